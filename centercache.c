@@ -0,0 +1,92 @@
+/*\
+ * Homework 2 - a neural network with a real-time preview
+ * Copyright (C) 2010 Matthew Donoughe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRENTY; without even the implied warrenty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. Tee the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Pubilc License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+\*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dataset.h"
+#include "centercache.h"
+
+// the start of every file, changed whenever the format or the clustering
+// changes so old files are ignored
+#define CENTER_CACHE_MAGIC 0x52424631
+
+// the key in the order it's written, without any padding
+static unsigned long long hashKey(const CenterKey *key) {
+  unsigned long long hash = hashBytes(FNV_OFFSET, &key->dataHash, sizeof(key->dataHash));
+  hash = hashBytes(hash, &key->seed, sizeof(key->seed));
+  hash = hashBytes(hash, &key->count, sizeof(key->count));
+  hash = hashBytes(hash, &key->algorithm, sizeof(key->algorithm));
+  return hashBytes(hash, &key->seeding, sizeof(key->seeding));
+}
+
+char *centerCachePath(const char *dataFile, const CenterKey *key) {
+  // the name, a dot, 16 hex digits, and .rbf
+  char *path = (char *)malloc(strlen(dataFile) + 22);
+  sprintf(path, "%s.%016llx.rbf", dataFile, hashKey(key));
+  return path;
+}
+
+int loadCenters(const char *path, const CenterKey *key, float *centers, int stride) {
+  FILE *f = fopen(path, "rb");
+  unsigned int magic;
+  CenterKey saved;
+  float center[3];
+  unsigned int j;
+  int ok;
+  if (f == NULL)
+    return 0;
+  ok = fread(&magic, sizeof(magic), 1, f) == 1 && magic == CENTER_CACHE_MAGIC;
+  ok = ok && fread(&saved.dataHash, sizeof(saved.dataHash), 1, f) == 1 && saved.dataHash == key->dataHash;
+  ok = ok && fread(&saved.seed, sizeof(saved.seed), 1, f) == 1 && saved.seed == key->seed;
+  ok = ok && fread(&saved.count, sizeof(saved.count), 1, f) == 1 && saved.count == key->count;
+  ok = ok && fread(&saved.algorithm, sizeof(saved.algorithm), 1, f) == 1 && saved.algorithm == key->algorithm;
+  ok = ok && fread(&saved.seeding, sizeof(saved.seeding), 1, f) == 1 && saved.seeding == key->seeding;
+  for (j = 0; ok && j < key->count; j++) {
+    ok = fread(center, sizeof(float), 3, f) == 3;
+    if (ok)
+      memcpy(centers + j * stride, center, sizeof(center));
+  }
+  fclose(f);
+  return ok;
+}
+
+int saveCenters(const char *path, const CenterKey *key, const float *centers, int stride) {
+  FILE *f = fopen(path, "wb");
+  unsigned int magic = CENTER_CACHE_MAGIC;
+  unsigned int j;
+  int ok;
+  if (f == NULL)
+    return 0;
+  ok = fwrite(&magic, sizeof(magic), 1, f) == 1;
+  ok = ok && fwrite(&key->dataHash, sizeof(key->dataHash), 1, f) == 1;
+  ok = ok && fwrite(&key->seed, sizeof(key->seed), 1, f) == 1;
+  ok = ok && fwrite(&key->count, sizeof(key->count), 1, f) == 1;
+  ok = ok && fwrite(&key->algorithm, sizeof(key->algorithm), 1, f) == 1;
+  ok = ok && fwrite(&key->seeding, sizeof(key->seeding), 1, f) == 1;
+  for (j = 0; ok && j < key->count; j++) {
+    ok = fwrite(centers + j * stride, sizeof(float), 3, f) == 3;
+  }
+  // don't leave half a file for the next run to trip over
+  if (fclose(f) != 0 || !ok) {
+    remove(path);
+    return 0;
+  }
+  return 1;
+}
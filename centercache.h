@@ -0,0 +1,28 @@
+#ifndef CENTERCACHE_H
+#define CENTERCACHE_H
+
+// the rbf centers found for a training set are saved next to it, so the next
+// run with the same set and settings can load them instead of clustering
+// again
+
+// everything the centers depend on
+typedef struct CenterKey {
+  // hashDataset of the training set
+  unsigned long long dataHash;
+  unsigned long long seed;
+  unsigned int count;
+  unsigned int algorithm;
+  unsigned int seeding;
+} CenterKey;
+
+// the file the centers for key go in, next to the training set file
+// the caller frees it
+char *centerCachePath(const char *dataFile, const CenterKey *key);
+
+// read count centers of meanx, meany, var laid out stride floats apart
+// returns 0 if there's no file for the key or it doesn't match
+int loadCenters(const char *path, const CenterKey *key, float *centers, int stride);
+// returns 0 if the file can't be written
+int saveCenters(const char *path, const CenterKey *key, const float *centers, int stride);
+
+#endif
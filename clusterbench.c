@@ -0,0 +1,150 @@
+/*\
+ * Homework 2 - a neural network with a real-time preview
+ * Copyright (C) 2010 Matthew Donoughe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRENTY; without even the implied warrenty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. Tee the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Pubilc License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+\*/
+
+// compares how long the k-means algorithms take to place the rbf centers
+// clusterbench [synthetic set size] [threads]
+// starts the centers each way, then runs each algorithm from the same starting
+// centers on circle.dat, spiral.dat, and a generated set of blobs, and checks
+// how far they end up from lloyd's centers
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "dataset.h"
+#include "kmeans.h"
+#include "rng.h"
+#include "threads.h"
+
+// laid out like the rbf weights
+#define STRIDE 3
+
+static const char *algorithmNames[] = {"lloyd", "hamerly", "minibatch"};
+static const char *seedingNames[] = {"random", "plusplus", "parallel"};
+
+static Pool pool;
+
+// size points scattered around a number of randomly placed blobs
+static void generateBlobs(Dataset *data, unsigned int size, int blobs) {
+  Rng rng;
+  unsigned int i;
+  seedRng(&rng, 1, 0);
+  allocateDataset(data, size);
+  for (i = 0; i < size; i++) {
+    // every point's blob center comes from the blob's own stream so the
+    // centers stay put
+    Rng blob;
+    double angle = 2.0 * 3.14159265358979 * randomUnit(&rng);
+    double radius = 1.5 * sqrt(-2.0 * log(1.0 - randomUnit(&rng)));
+    int b = randomBelow(&rng, blobs);
+    seedRng(&blob, 2 + b, 0);
+    data->x[i] = 16.0 * randomUnit(&blob) - 8.0 + radius * cos(angle);
+    data->y[i] = 16.0 * randomUnit(&blob) - 8.0 + radius * sin(angle);
+    data->target[i] = 2 * (b % 2) - 1;
+  }
+}
+
+// the mean squared distance from each input to its closest center, which is
+// what k-means tries to make small
+static double cost(const float *centers, int count, const Dataset *data) {
+  double total = 0.0;
+  unsigned int i;
+  int j;
+  for (i = 0; i < data->size; i++) {
+    double best = HUGE_VAL;
+    for (j = 0; j < count; j++) {
+      double dx = data->x[i] - centers[j * STRIDE];
+      double dy = data->y[i] - centers[j * STRIDE + 1];
+      if (dx * dx + dy * dy < best)
+        best = dx * dx + dy * dy;
+    }
+    total += best;
+  }
+  return total / data->size;
+}
+
+// time each algorithm from the same starting centers
+static void benchmark(const char *name, const Dataset *data, int count, KMeansSeeding seeding) {
+  float *start = (float *)malloc(count * STRIDE * sizeof(float));
+  float *centers[3];
+  double seedMs;
+  clock_t begin;
+  Rng rng;
+  int a, i;
+  if ((unsigned int)count > data->size)
+    return;
+  seedRng(&rng, 1, 0);
+  begin = clock();
+  seedCenters(start, STRIDE, count, data, seeding, &rng, &pool);
+  seedMs = (double)(clock() - begin) * 1000.0 / CLOCKS_PER_SEC;
+  for (a = 0; a < 3; a++) {
+    double ms;
+    double difference = 0.0;
+    unsigned int iterations;
+    centers[a] = (float *)malloc(count * STRIDE * sizeof(float));
+    memcpy(centers[a], start, count * STRIDE * sizeof(float));
+    begin = clock();
+    if (a == KMEANS_MINIBATCH) {
+      DatasetStream stream;
+      seedRng(&rng, 1, 1);
+      streamDataset(&stream, data);
+      iterations = miniBatchKMeans(centers[a], STRIDE, count, &stream, MINIBATCH_SIZE, MINIBATCH_LIMIT, MINIBATCH_TOLERANCE, &rng);
+    } else {
+      iterations = kmeans(centers[a], STRIDE, count, data, (KMeansAlgorithm)a, &pool);
+    }
+    ms = (double)(clock() - begin) * 1000.0 / CLOCKS_PER_SEC;
+    for (i = 0; i < count * STRIDE; i++) {
+      double d = fabs(centers[a][i] - centers[0][i]);
+      if (d > difference)
+        difference = d;
+    }
+    printf("%s\t%u\t%d\t%s\t%.3f\t%s\t%u\t%.3f\t%g\t%g\n", name, data->size, count, seedingNames[seeding], seedMs, algorithmNames[a], iterations, ms, cost(centers[a], count, data), difference);
+  }
+  for (a = 0; a < 3; a++) {
+    free(centers[a]);
+  }
+  free(start);
+}
+
+// every seeding with every number of centers
+static void benchmarkAll(const char *name, const Dataset *data) {
+  static const int counts[] = {10, 50, 150};
+  int c, s;
+  for (c = 0; c < 3; c++) {
+    for (s = 0; s < 3; s++) {
+      benchmark(name, data, counts[c], (KMeansSeeding)s);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  unsigned int size = argc > 1 ? atoi(argv[1]) : 100000;
+  unsigned int threads = argc > 2 ? atoi(argv[2]) : 1;
+  Dataset circle, spiral, blobs;
+  initPool(&pool, threads < 1 ? 1 : threads);
+  printf("set\tinputs\tcenters\tseeding\tseed ms\talgorithm\titerations\tms\tcost\tdifference\n");
+  if (readDataset(&circle, "circle.dat", &pool))
+    benchmarkAll("circle.dat", &circle);
+  if (readDataset(&spiral, "spiral.dat", &pool))
+    benchmarkAll("spiral.dat", &spiral);
+  generateBlobs(&blobs, size, 64);
+  benchmarkAll("blobs", &blobs);
+  return 0;
+}
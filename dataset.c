@@ -0,0 +1,685 @@
+/*\
+ * Homework 2 - a neural network with a real-time preview
+ * Copyright (C) 2010 Matthew Donoughe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRENTY; without even the implied warrenty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. Tee the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Pubilc License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+\*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <locale.h>
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef __WIN32__
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "dataset.h"
+
+#ifdef _MSC_VER
+#define fseeko _fseeki64
+#define ftello _ftelli64
+#endif
+
+// "H2DATA" and a version, for the start of a binary file
+#define BINARY_MAGIC 0x3130415441443248ULL
+
+// the start of a binary file
+// everything is 64 bits so there's no padding to worry about
+typedef struct BinaryHeader {
+  unsigned long long magic;
+  unsigned long long size;
+  // the text file it was written from, or zeros
+  unsigned long long sourceSize;
+  unsigned long long sourceTime;
+  // where the columns start
+  unsigned long long xOffset;
+  unsigned long long yOffset;
+  unsigned long long targetOffset;
+  unsigned long long reserved;
+} BinaryHeader;
+
+// malloc with the start moved up to the alignment
+// the pointer malloc returned is kept just before the block for alignedFree
+// posix_memalign and _aligned_malloc aren't everywhere this builds
+static void *alignedMalloc(size_t size) {
+  char *block = (char *)malloc(size + DATASET_ALIGNMENT + sizeof(void *));
+  char *aligned;
+  if (block == NULL)
+    return NULL;
+  aligned = block + sizeof(void *);
+  aligned += (DATASET_ALIGNMENT - (size_t)aligned % DATASET_ALIGNMENT) % DATASET_ALIGNMENT;
+  ((void **)aligned)[-1] = block;
+  return aligned;
+}
+
+static void alignedFree(void *aligned) {
+  if (aligned != NULL)
+    free(((void **)aligned)[-1]);
+}
+
+// map a whole file copy on write, so it can be changed in memory without
+// touching the file
+// an empty file gets a NULL mapping
+// returns 0 if it can't be opened or mapped
+static int mapFile(const char *file, void **mapping, size_t *length) {
+#ifdef __WIN32__
+  HANDLE f, section;
+  LARGE_INTEGER fileSize;
+  f = CreateFileA(file, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (f == INVALID_HANDLE_VALUE)
+    return 0;
+  if (!GetFileSizeEx(f, &fileSize) || fileSize.QuadPart != (size_t)fileSize.QuadPart) {
+    CloseHandle(f);
+    return 0;
+  }
+  *length = (size_t)fileSize.QuadPart;
+  *mapping = NULL;
+  if (*length == 0) {
+    CloseHandle(f);
+    return 1;
+  }
+  section = CreateFileMappingA(f, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+  CloseHandle(f);
+  if (section == NULL)
+    return 0;
+  *mapping = MapViewOfFile(section, FILE_MAP_COPY, 0, 0, 0);
+  // the view keeps the file open
+  CloseHandle(section);
+  return *mapping != NULL;
+#else
+  struct stat info;
+  int f = open(file, O_RDONLY);
+  if (f < 0)
+    return 0;
+  if (fstat(f, &info) != 0 || (off_t)(size_t)info.st_size != info.st_size) {
+    close(f);
+    return 0;
+  }
+  *length = info.st_size;
+  *mapping = NULL;
+  if (*length > 0) {
+    *mapping = mmap(NULL, *length, PROT_READ | PROT_WRITE, MAP_PRIVATE, f, 0);
+    if (*mapping == MAP_FAILED)
+      *mapping = NULL;
+  }
+  // the mapping keeps the file open
+  close(f);
+  return *length == 0 || *mapping != NULL;
+#endif
+}
+
+static void unmapFile(void *mapping, size_t length) {
+  if (mapping == NULL)
+    return;
+#ifdef __WIN32__
+  UnmapViewOfFile(mapping);
+#else
+  munmap(mapping, length);
+#endif
+}
+
+void allocateDataset(Dataset *data, unsigned int size) {
+  data->size = size;
+  data->x = (float *)alignedMalloc(size * sizeof(float));
+  data->y = (float *)alignedMalloc(size * sizeof(float));
+  data->target = (int *)alignedMalloc(size * sizeof(int));
+  data->mapping = NULL;
+  data->mappingSize = 0;
+}
+
+void freeDataset(Dataset *data) {
+  if (data->mapping != NULL) {
+    unmapFile(data->mapping, data->mappingSize);
+  } else {
+    alignedFree(data->x);
+    alignedFree(data->y);
+    alignedFree(data->target);
+  }
+  data->mapping = NULL;
+  data->mappingSize = 0;
+  data->size = 0;
+  data->x = NULL;
+  data->y = NULL;
+  data->target = NULL;
+}
+
+// whether a binary file's header makes sense for a file of length bytes, and
+// with source, whether it was written from source as it is now
+static int checkHeader(const BinaryHeader *header, unsigned long long length, const char *source) {
+  struct stat info;
+  if (header->magic != BINARY_MAGIC || header->size != (unsigned int)header->size)
+    return 0;
+  if (header->xOffset % DATASET_ALIGNMENT != 0 || header->yOffset % DATASET_ALIGNMENT != 0 || header->targetOffset % DATASET_ALIGNMENT != 0)
+    return 0;
+  if (header->xOffset + header->size * sizeof(float) > length || header->yOffset + header->size * sizeof(float) > length || header->targetOffset + header->size * sizeof(int) > length)
+    return 0;
+  return source == NULL || (stat(source, &info) == 0 && header->sourceSize == (unsigned long long)info.st_size && header->sourceTime == (unsigned long long)info.st_mtime);
+}
+
+int openBinaryDatasetStream(DatasetStream *stream, const char *file, const char *source) {
+  BinaryHeader header;
+  long long length;
+  stream->file = fopen(file, "rb");
+  stream->memory = NULL;
+  stream->position = 0;
+  if (stream->file == NULL)
+    return 0;
+  if (fseeko(stream->file, 0, SEEK_END) != 0 || (length = ftello(stream->file)) < 0 || fseeko(stream->file, 0, SEEK_SET) != 0 ||
+      fread(&header, sizeof(header), 1, stream->file) != 1 || !checkHeader(&header, length, source)) {
+    closeDatasetStream(stream);
+    return 0;
+  }
+  stream->binary = 1;
+  stream->size = (unsigned int)header.size;
+  stream->xOffset = header.xOffset;
+  stream->yOffset = header.yOffset;
+  stream->targetOffset = header.targetOffset;
+  return 1;
+}
+
+int openDatasetStream(DatasetStream *stream, const char *file) {
+  if (openBinaryDatasetStream(stream, file, NULL))
+    return 1;
+  stream->file = fopen(file, "r");
+  stream->binary = 0;
+  stream->memory = NULL;
+  stream->size = 0;
+  stream->position = 0;
+  return stream->file != NULL;
+}
+
+void streamDataset(DatasetStream *stream, const Dataset *data) {
+  stream->file = NULL;
+  stream->binary = 0;
+  stream->memory = data;
+  stream->size = data->size;
+  stream->position = 0;
+}
+
+// read count of a column's values starting with value first
+static int readColumn(FILE *file, unsigned long long offset, void *values, size_t size, unsigned int first, unsigned int count) {
+  return fseeko(file, offset + (unsigned long long)first * size, SEEK_SET) == 0 && fread(values, size, count, file) == count;
+}
+
+unsigned int readDatasetBlock(DatasetStream *stream, Dataset *chunk, unsigned int first, unsigned int count) {
+  count = first >= stream->size ? 0 : (count > stream->size - first ? stream->size - first : count);
+  if (stream->binary) {
+    if (!readColumn(stream->file, stream->xOffset, chunk->x, sizeof(float), first, count) ||
+        !readColumn(stream->file, stream->yOffset, chunk->y, sizeof(float), first, count) ||
+        !readColumn(stream->file, stream->targetOffset, chunk->target, sizeof(int), first, count))
+      count = 0;
+  } else if (stream->memory != NULL) {
+    memcpy(chunk->x, stream->memory->x + first, count * sizeof(float));
+    memcpy(chunk->y, stream->memory->y + first, count * sizeof(float));
+    memcpy(chunk->target, stream->memory->target + first, count * sizeof(int));
+  }
+  chunk->size = count;
+  return count;
+}
+
+unsigned int readDatasetChunk(DatasetStream *stream, Dataset *chunk, unsigned int capacity) {
+  unsigned int count = 0;
+  if (stream->file != NULL && !stream->binary) {
+    double x;
+    double y;
+    int target;
+    while (count < capacity && fscanf(stream->file, "%lf\t%lf\t%d\n", &x, &y, &target) == 3) {
+      chunk->x[count] = x;
+      chunk->y[count] = y;
+      chunk->target[count] = 2 * target - 1;
+      count++;
+    }
+    chunk->size = count;
+  } else {
+    count = readDatasetBlock(stream, chunk, stream->position, capacity);
+    stream->position += count;
+  }
+  return count;
+}
+
+void rewindDatasetStream(DatasetStream *stream) {
+  if (stream->file != NULL)
+    rewind(stream->file);
+  stream->position = 0;
+}
+
+int closeDatasetStream(DatasetStream *stream) {
+  int ok = 1;
+  if (stream->file != NULL)
+    ok = fclose(stream->file) == 0;
+  stream->file = NULL;
+  stream->memory = NULL;
+  return ok;
+}
+
+// the part of a text file one thread parses, which starts at the start of a
+// line
+typedef struct TextChunk {
+  const char *start;
+  const char *end;
+  // the number of lines with an input on them, and of all lines
+  unsigned int inputs;
+  unsigned int lines;
+  // the index of the first input and the number of the first line
+  unsigned int first;
+  unsigned int firstLine;
+  // the number of the first line that couldn't be parsed, or 0
+  unsigned int badLine;
+} TextChunk;
+
+typedef struct TextParse {
+  TextChunk *chunks;
+  Dataset *data;
+} TextParse;
+
+// the powers of ten a double holds exactly
+static const double powersOfTen[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static int isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static int isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+// the end of the line starting at p, or end
+static const char *lineEnd(const char *p, const char *end) {
+  const char *newline = (const char *)memchr(p, '\n', end - p);
+  return newline != NULL ? newline : end;
+}
+
+// the "C" locale, for reading numbers with a . whatever LC_NUMERIC says
+#ifdef __WIN32__
+static _locale_t numberLocale;
+#else
+static locale_t numberLocale;
+#endif
+
+// read a number like 1, -0.25, or 3e-5 at p and move p past it
+// with at most 19 digits and a power of ten a double holds exactly, the digits
+// make a whole number a double holds exactly too, so one multiply or divide
+// rounds the same way strtod does(Clinger's fast path). Anything else goes to
+// strtod, which would follow LC_NUMERIC and want a , for the decimal point in
+// some locales, so it's run in numberLocale
+// returns 0 if there's no number there
+static int parseNumber(const char **p, const char *end, double *value) {
+  const char *s = *p;
+  unsigned long long mantissa = 0;
+  int exponent = 0;
+  int digits = 0;
+  int truncated = 0;
+  int negative = 0;
+  int any = 0;
+  if (s < end && (*s == '-' || *s == '+'))
+    negative = *s++ == '-';
+  for (; s < end && isDigit(*s); s++) {
+    any = 1;
+    if (digits < 19) {
+      mantissa = mantissa * 10 + (*s - '0');
+      digits += mantissa != 0;
+    } else {
+      truncated |= *s != '0';
+      exponent++;
+    }
+  }
+  if (s < end && *s == '.') {
+    for (s++; s < end && isDigit(*s); s++) {
+      any = 1;
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (*s - '0');
+        digits += mantissa != 0;
+        exponent--;
+      } else {
+        truncated |= *s != '0';
+      }
+    }
+  }
+  if (!any)
+    return 0;
+  if (s < end && (*s == 'e' || *s == 'E')) {
+    int power = 0;
+    int negativePower = 0;
+    s++;
+    if (s < end && (*s == '-' || *s == '+'))
+      negativePower = *s++ == '-';
+    if (s == end || !isDigit(*s))
+      return 0;
+    for (; s < end && isDigit(*s); s++) {
+      if (power < 100000)
+        power = power * 10 + (*s - '0');
+    }
+    exponent += negativePower ? -power : power;
+  }
+  if (!truncated && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+    *value = exponent < 0 ? mantissa / powersOfTen[-exponent] : mantissa * powersOfTen[exponent];
+    if (negative)
+      *value = -*value;
+  } else {
+    char number[64];
+#ifndef __WIN32__
+    locale_t locale;
+#endif
+    if (s - *p >= (int)sizeof(number))
+      return 0;
+    memcpy(number, *p, s - *p);
+    number[s - *p] = '\0';
+#ifdef __WIN32__
+    *value = _strtod_l(number, NULL, numberLocale);
+#else
+    // uselocale only changes the calling thread's locale
+    locale = uselocale(numberLocale);
+    *value = strtod(number, NULL);
+    uselocale(locale);
+#endif
+  }
+  *p = s;
+  return 1;
+}
+
+// count the lines in the thread's chunk
+static void countLines(unsigned int thread, void *arg) {
+  TextChunk *chunk = ((TextParse *)arg)->chunks + thread;
+  const char *p = chunk->start;
+  chunk->inputs = 0;
+  chunk->lines = 0;
+  while (p < chunk->end) {
+    const char *e = lineEnd(p, chunk->end);
+    chunk->lines++;
+    // blank lines are skipped
+    while (p < e && isSpace(*p)) {
+      p++;
+    }
+    chunk->inputs += p < e;
+    p = e + 1;
+  }
+}
+
+// parse the lines in the thread's chunk into its part of the columns
+static void parseLines(unsigned int thread, void *arg) {
+  TextParse *parse = (TextParse *)arg;
+  TextChunk *chunk = parse->chunks + thread;
+  const char *p = chunk->start;
+  unsigned int i = chunk->first;
+  unsigned int line = chunk->firstLine;
+  chunk->badLine = 0;
+  for (; p < chunk->end; p++, line++) {
+    const char *e = lineEnd(p, chunk->end);
+    double x, y, target;
+    while (p < e && isSpace(*p)) {
+      p++;
+    }
+    if (p == e)
+      continue;
+    // X, Y, and TARGET with space between them and maybe after
+    if (!parseNumber(&p, e, &x) || p == e || !isSpace(*p)) {
+      chunk->badLine = line;
+      return;
+    }
+    while (p < e && isSpace(*p)) {
+      p++;
+    }
+    if (!parseNumber(&p, e, &y) || p == e || !isSpace(*p)) {
+      chunk->badLine = line;
+      return;
+    }
+    while (p < e && isSpace(*p)) {
+      p++;
+    }
+    if (!parseNumber(&p, e, &target) || target != (int)target) {
+      chunk->badLine = line;
+      return;
+    }
+    while (p < e && isSpace(*p)) {
+      p++;
+    }
+    if (p != e) {
+      chunk->badLine = line;
+      return;
+    }
+    parse->data->x[i] = x;
+    parse->data->y[i] = y;
+    parse->data->target[i] = 2 * (int)target - 1;
+    i++;
+  }
+}
+
+int readTextDataset(Dataset *data, const char *file, Pool *pool) {
+  TextParse parse;
+  const char *text;
+  void *mapping;
+  size_t length;
+  unsigned int t, inputs = 0, lines = 1;
+  if (!mapFile(file, &mapping, &length))
+    return 0;
+  text = (const char *)mapping;
+  // made once before the threads need it, and kept for the next file
+  if (numberLocale == NULL) {
+#ifdef __WIN32__
+    numberLocale = _create_locale(LC_NUMERIC, "C");
+#else
+    numberLocale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+#endif
+    if (numberLocale == NULL) {
+      unmapFile(mapping, length);
+      return 0;
+    }
+  }
+  // cut the text into a chunk for each thread, moving each cut to the start of
+  // a line
+  parse.chunks = (TextChunk *)malloc(pool->threads * sizeof(TextChunk));
+  parse.data = data;
+  for (t = 0; t < pool->threads; t++) {
+    const char *start = text + (unsigned long long)length * t / pool->threads;
+    if (t == 0) {
+      start = text;
+    } else if (start < parse.chunks[t - 1].start) {
+      start = parse.chunks[t - 1].start;
+    } else {
+      while (start < text + length && start[-1] != '\n') {
+        start++;
+      }
+    }
+    parse.chunks[t].start = start;
+    if (t > 0)
+      parse.chunks[t - 1].end = start;
+  }
+  parse.chunks[pool->threads - 1].end = text + length;
+  // count the lines so every chunk knows where its inputs go and what its
+  // line numbers are, then parse them straight into the columns
+  runPool(pool, &countLines, &parse);
+  for (t = 0; t < pool->threads; t++) {
+    parse.chunks[t].first = inputs;
+    parse.chunks[t].firstLine = lines;
+    inputs += parse.chunks[t].inputs;
+    lines += parse.chunks[t].lines;
+  }
+  allocateDataset(data, inputs);
+  runPool(pool, &parseLines, &parse);
+  unmapFile(mapping, length);
+  for (t = 0; t < pool->threads; t++) {
+    if (parse.chunks[t].badLine != 0) {
+      fprintf(stderr, "%s:%u: expected \"X\tY\tTARGET\"\n", file, parse.chunks[t].badLine);
+      freeDataset(data);
+      free(parse.chunks);
+      return 0;
+    }
+  }
+  free(parse.chunks);
+  return 1;
+}
+
+int readDataset(Dataset *data, const char *file, Pool *pool) {
+  // file.bin
+  char *binary = (char *)malloc(strlen(file) + 5);
+  int ok = 1;
+  sprintf(binary, "%s.bin", file);
+  if (!mapBinaryDataset(data, file, NULL) && !mapBinaryDataset(data, binary, file)) {
+    ok = readTextDataset(data, file, pool);
+    // not being able to write it just means parsing again next time
+    // there's nothing to save parsing for an empty one
+    if (ok && data->size > 0)
+      writeBinaryDataset(data, binary, file);
+  }
+  free(binary);
+  return ok;
+}
+
+// where a column that starts at offset and takes size bytes ends, rounded up
+// to where the next one can start
+static unsigned long long columnEnd(unsigned long long offset, unsigned long long size) {
+  return (offset + size + DATASET_ALIGNMENT - 1) / DATASET_ALIGNMENT * DATASET_ALIGNMENT;
+}
+
+// the header of a binary file of size inputs, without a source
+static void layOutHeader(BinaryHeader *header, unsigned int size) {
+  memset(header, 0, sizeof(*header));
+  header->magic = BINARY_MAGIC;
+  header->size = size;
+  header->xOffset = columnEnd(0, sizeof(*header));
+  header->yOffset = columnEnd(header->xOffset, size * sizeof(float));
+  header->targetOffset = columnEnd(header->yOffset, size * sizeof(float));
+}
+
+int writeBinaryDataset(const Dataset *data, const char *file, const char *source) {
+  BinaryHeader header;
+  struct stat info;
+  static const char zeros[DATASET_ALIGNMENT] = {0};
+  FILE *f;
+  int ok;
+  layOutHeader(&header, data->size);
+  if (source != NULL) {
+    if (stat(source, &info) != 0)
+      return 0;
+    header.sourceSize = info.st_size;
+    header.sourceTime = info.st_mtime;
+  }
+  f = fopen(file, "wb");
+  if (f == NULL)
+    return 0;
+  ok = fwrite(&header, sizeof(header), 1, f) == 1;
+  ok = ok && fwrite(zeros, 1, header.xOffset - sizeof(header), f) == header.xOffset - sizeof(header);
+  ok = ok && fwrite(data->x, sizeof(float), data->size, f) == data->size;
+  ok = ok && fwrite(zeros, 1, header.yOffset - header.xOffset - data->size * sizeof(float), f) == header.yOffset - header.xOffset - data->size * sizeof(float);
+  ok = ok && fwrite(data->y, sizeof(float), data->size, f) == data->size;
+  ok = ok && fwrite(zeros, 1, header.targetOffset - header.yOffset - data->size * sizeof(float), f) == header.targetOffset - header.yOffset - data->size * sizeof(float);
+  ok = ok && fwrite(data->target, sizeof(int), data->size, f) == data->size;
+  // don't leave half a file to be mapped later
+  if (fclose(f) != 0 || !ok) {
+    remove(file);
+    return 0;
+  }
+  return 1;
+}
+
+int createBinaryDataset(DatasetStream *stream, const char *file, unsigned int size) {
+  BinaryHeader header;
+  unsigned long long end;
+  layOutHeader(&header, size);
+  end = header.targetOffset + (unsigned long long)size * sizeof(int);
+  stream->file = fopen(file, "wb");
+  stream->binary = 1;
+  stream->memory = NULL;
+  stream->size = size;
+  stream->position = 0;
+  stream->xOffset = header.xOffset;
+  stream->yOffset = header.yOffset;
+  stream->targetOffset = header.targetOffset;
+  if (stream->file == NULL)
+    return 0;
+  // the columns are filled in later, the last byte just makes the file its
+  // full length
+  if (fwrite(&header, sizeof(header), 1, stream->file) != 1 || fseeko(stream->file, end - 1, SEEK_SET) != 0 || fputc(0, stream->file) == EOF) {
+    closeDatasetStream(stream);
+    remove(file);
+    return 0;
+  }
+  return 1;
+}
+
+// write count of a column's values starting with value first
+static int writeColumn(FILE *file, unsigned long long offset, const void *values, size_t size, unsigned int first, unsigned int count) {
+  return fseeko(file, offset + (unsigned long long)first * size, SEEK_SET) == 0 && fwrite(values, size, count, file) == count;
+}
+
+int writeDatasetBlock(DatasetStream *stream, const Dataset *chunk, unsigned int first) {
+  if (first > stream->size || chunk->size > stream->size - first)
+    return 0;
+  return writeColumn(stream->file, stream->xOffset, chunk->x, sizeof(float), first, chunk->size) &&
+      writeColumn(stream->file, stream->yOffset, chunk->y, sizeof(float), first, chunk->size) &&
+      writeColumn(stream->file, stream->targetOffset, chunk->target, sizeof(int), first, chunk->size);
+}
+
+int mapBinaryDataset(Dataset *data, const char *file, const char *source) {
+  BinaryHeader *header;
+  void *mapping;
+  size_t length;
+  if (!mapFile(file, &mapping, &length))
+    return 0;
+  if (length < sizeof(BinaryHeader)) {
+    unmapFile(mapping, length);
+    return 0;
+  }
+  header = (BinaryHeader *)mapping;
+  if (!checkHeader(header, length, source) || header->size == 0) {
+    unmapFile(mapping, length);
+    return 0;
+  }
+  data->size = (unsigned int)header->size;
+  data->x = (float *)((char *)mapping + header->xOffset);
+  data->y = (float *)((char *)mapping + header->yOffset);
+  data->target = (int *)((char *)mapping + header->targetOffset);
+  data->mapping = mapping;
+  data->mappingSize = length;
+  return 1;
+}
+
+unsigned long long hashBytes(unsigned long long hash, const void *bytes, size_t size) {
+  const unsigned char *b = (const unsigned char *)bytes;
+  size_t i;
+  for (i = 0; i < size; i++) {
+    hash ^= b[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+unsigned long long hashDataset(const Dataset *data) {
+  unsigned long long hash = hashBytes(FNV_OFFSET, &data->size, sizeof(data->size));
+  hash = hashBytes(hash, data->x, data->size * sizeof(float));
+  hash = hashBytes(hash, data->y, data->size * sizeof(float));
+  return hashBytes(hash, data->target, data->size * sizeof(int));
+}
+
+void gatherDataset(Dataset *destination, const Dataset *source, const unsigned int *order) {
+  unsigned int i;
+  for (i = 0; i < destination->size; i++) {
+    destination->x[i] = source->x[order[i]];
+    destination->y[i] = source->y[order[i]];
+    destination->target[i] = source->target[order[i]];
+  }
+}
@@ -0,0 +1,115 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <stdio.h>
+
+#include "threads.h"
+
+// the columns are aligned to this many bytes, enough for any vector load
+#define DATASET_ALIGNMENT 64
+
+// a training set stored a column at a time, so walking through it in order
+// reads each column sequentially
+typedef struct Dataset {
+  // number of input vectors
+  unsigned int size;
+  // input coordinates
+  float *x;
+  float *y;
+  // -1 or 1
+  int *target;
+  // the binary file the columns point into, or NULL if they were allocated
+  void *mapping;
+  size_t mappingSize;
+} Dataset;
+
+// make room for size inputs
+void allocateDataset(Dataset *data, unsigned int size);
+void freeDataset(Dataset *data);
+
+// read a binary file written by writeBinaryDataset, or lines of
+// "X\tY\tTARGET" where TARGET is 0 or 1
+// a text file is only parsed once: its inputs are saved to file.bin next to it,
+// which later calls map instead as long as the text file hasn't changed
+// text files are parsed by the pool's threads, a piece each
+// returns 0 if the file can't be opened or a line isn't an input, which is
+// reported on stderr with its line number
+int readDataset(Dataset *data, const char *file, Pool *pool);
+
+// parse lines of "X\tY\tTARGET" without looking for a binary file
+// blank lines are skipped and any spaces or tabs can go between the numbers
+int readTextDataset(Dataset *data, const char *file, Pool *pool);
+
+// the binary format is a 64 byte header followed by the x, y, and target
+// columns, each starting on a multiple of 64 bytes, in the byte order of the
+// machine that wrote it
+// it's memory mapped as is, so loading it doesn't copy or parse anything
+// source is the text file the inputs came from, whose size and modification
+// time are saved in the header, or NULL
+// returns 0 if the file can't be written
+int writeBinaryDataset(const Dataset *data, const char *file, const char *source);
+// map a binary file
+// with source, only if it was written from source as it is now
+// returns 0 if the file isn't a binary dataset, doesn't match, or is empty
+int mapBinaryDataset(Dataset *data, const char *file, const char *source);
+
+// reads a training set a chunk at a time, either from a file so it never has
+// to fit in memory, or from a Dataset that's already loaded
+typedef struct DatasetStream {
+  // the file being read, or NULL
+  FILE *file;
+  // whether the file is in the binary format, and where its columns are
+  unsigned char binary;
+  unsigned long long xOffset;
+  unsigned long long yOffset;
+  unsigned long long targetOffset;
+  // otherwise the inputs being read
+  const Dataset *memory;
+  // the number of inputs, except for text files where it isn't known
+  unsigned int size;
+  // how far into them the stream is
+  unsigned int position;
+} DatasetStream;
+
+// open a text or binary file
+// returns 0 if the file can't be opened
+int openDatasetStream(DatasetStream *stream, const char *file);
+// open a binary file, with source only if it was written from source as it is
+// now, like mapBinaryDataset
+// returns 0 if the file can't be opened or isn't a binary dataset
+int openBinaryDatasetStream(DatasetStream *stream, const char *file, const char *source);
+// stream the inputs of a loaded Dataset, which has to outlive the stream
+void streamDataset(DatasetStream *stream, const Dataset *data);
+// read up to capacity inputs into chunk, which has room for that many, and set
+// its size to the number read
+// returns the number read, which is 0 once the stream runs out
+unsigned int readDatasetChunk(DatasetStream *stream, Dataset *chunk, unsigned int capacity);
+// read up to count inputs starting with input first, wherever the stream is,
+// the same way
+// text files can't be read out of order, so they always give 0
+unsigned int readDatasetBlock(DatasetStream *stream, Dataset *chunk, unsigned int first, unsigned int count);
+// start again from the first input
+void rewindDatasetStream(DatasetStream *stream);
+// returns 0 if a file being written couldn't be finished
+int closeDatasetStream(DatasetStream *stream);
+
+// write a binary file a block at a time, for sets too big to hold at once
+// creates the file with room for size inputs, which are all 0 until written
+// returns 0 if the file can't be written
+int createBinaryDataset(DatasetStream *stream, const char *file, unsigned int size);
+// write chunk's inputs as inputs first up to first + chunk->size
+// returns 0 if they can't be written
+int writeDatasetBlock(DatasetStream *stream, const Dataset *chunk, unsigned int first);
+
+// 64 bit FNV-1a, http://www.isthe.com/chongo/tech/comp/fnv/
+// start hash at FNV_OFFSET and feed it the bytes a piece at a time
+#define FNV_OFFSET 14695981039346656037ULL
+unsigned long long hashBytes(unsigned long long hash, const void *bytes, size_t size);
+// a hash of everything in the inputs, to tell whether two sets are the same
+unsigned long long hashDataset(const Dataset *data);
+
+// copy source's inputs into destination in the given order
+// destination has to be allocated to hold them already
+void gatherDataset(Dataset *destination, const Dataset *source, const unsigned int *order);
+
+#endif
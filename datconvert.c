@@ -0,0 +1,57 @@
+/*\
+ * Homework 2 - a neural network with a real-time preview
+ * Copyright (C) 2010 Matthew Donoughe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRENTY; without even the implied warrenty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. Tee the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Pubilc License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+\*/
+
+// converts a text training set to the binary format readDataset maps
+// datconvert <file.dat> [file.bin [threads]]
+// the binary file defaults to file.dat.bin, which readDataset uses in place of
+// file.dat until file.dat changes
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dataset.h"
+#include "threads.h"
+
+int main(int argc, char **argv) {
+  Dataset data;
+  Pool pool;
+  char *binary;
+  int threads = argc > 3 ? atoi(argv[3]) : 1;
+  if (argc < 2 || argc > 4) {
+    fprintf(stderr, "usage: %s <file.dat> [file.bin [threads]]\n", argv[0]);
+    return 1;
+  }
+  initPool(&pool, threads < 1 ? 1 : threads);
+  if (!readTextDataset(&data, argv[1], &pool)) {
+    fprintf(stderr, "Can't read %s.\n", argv[1]);
+    return 1;
+  }
+  if (argc > 2) {
+    binary = argv[2];
+  } else {
+    binary = (char *)malloc(strlen(argv[1]) + 5);
+    sprintf(binary, "%s.bin", argv[1]);
+  }
+  if (!writeBinaryDataset(&data, binary, argv[1])) {
+    fprintf(stderr, "Can't write %s.\n", binary);
+    return 1;
+  }
+  printf("%u inputs written to %s\n", data.size, binary);
+  return 0;
+}
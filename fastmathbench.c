@@ -0,0 +1,155 @@
+/*\
+ * Homework 2 - a neural network with a real-time preview
+ * Copyright (C) 2010 Matthew Donoughe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRENTY; without even the implied warrenty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. Tee the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Pubilc License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+\*/
+
+// compares the fastmath.h functions with libm
+// fastmathbench [data file] [epochs]
+// prints the worst error of each function, how long a call takes, and how far
+// the same networks get in the same number of epochs with each accuracy
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+
+#include "main.h"
+#include "nn.h"
+#include "fastmath.h"
+
+// how many inputs are timed and how many times
+#define SAMPLES 4096
+#define REPEATS 4000
+
+GLData glData;
+NNData nnData;
+
+static double libmLogistic(double x) {
+  return 1.0 / (1.0 + exp(-x));
+}
+
+// the largest difference from libm, relative for exp and absolute otherwise
+static void measureError() {
+  double expErrors[2] = {0.0, 0.0};
+  double tanhErrors[2] = {0.0, 0.0};
+  double logisticErrors[2] = {0.0, 0.0};
+  double x;
+  for (x = -700.0; x <= 700.0; x += 0.00123) {
+    double e = exp(x);
+    expErrors[0] = fmax(expErrors[0], fabs(fastExp(x) - e) / e);
+    expErrors[1] = fmax(expErrors[1], fabs(fasterExp(x) - e) / e);
+  }
+  for (x = -40.0; x <= 40.0; x += 0.0000123) {
+    double t = tanh(x);
+    double l = libmLogistic(x);
+    tanhErrors[0] = fmax(tanhErrors[0], fabs(fastTanh(x) - t));
+    tanhErrors[1] = fmax(tanhErrors[1], fabs(fasterTanh(x) - t));
+    logisticErrors[0] = fmax(logisticErrors[0], fabs(fastLogistic(x) - l));
+    logisticErrors[1] = fmax(logisticErrors[1], fabs(fasterLogistic(x) - l));
+  }
+  printf("max error\tfast\tfaster\n");
+  printf("exp\t%g\t%g\n", expErrors[0], expErrors[1]);
+  printf("tanh\t%g\t%g\n", tanhErrors[0], tanhErrors[1]);
+  printf("logistic\t%g\t%g\n", logisticErrors[0], logisticErrors[1]);
+}
+
+// nanoseconds per call of f over the inputs
+// a macro instead of a function pointer so f gets inlined and vectorized like
+// it would be in nn.c
+#define TIME(f, inputs, outputs, ns) \
+  { \
+    clock_t start = clock(); \
+    int r, i; \
+    for (r = 0; r < REPEATS; r++) { \
+      for (i = 0; i < SAMPLES; i++) { \
+        outputs[i] = f(inputs[i]); \
+      } \
+      inputs[r % SAMPLES] = outputs[r % SAMPLES] * 0.0 + inputs[r % SAMPLES]; \
+    } \
+    ns = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / ((double)REPEATS * SAMPLES); \
+  }
+
+static void measureSpeed() {
+  double *inputs = (double *)malloc(SAMPLES * sizeof(double));
+  double *outputs = (double *)malloc(SAMPLES * sizeof(double));
+  double ns[3];
+  int i;
+  // the range activation functions usually see
+  for (i = 0; i < SAMPLES; i++) {
+    inputs[i] = 20.0 * i / SAMPLES - 10.0;
+  }
+  printf("ns per call\tlibm\tfast\tfaster\n");
+  TIME(exp, inputs, outputs, ns[0]);
+  TIME(fastExp, inputs, outputs, ns[1]);
+  TIME(fasterExp, inputs, outputs, ns[2]);
+  printf("exp\t%.2f\t%.2f\t%.2f\n", ns[0], ns[1], ns[2]);
+  TIME(tanh, inputs, outputs, ns[0]);
+  TIME(fastTanh, inputs, outputs, ns[1]);
+  TIME(fasterTanh, inputs, outputs, ns[2]);
+  printf("tanh\t%.2f\t%.2f\t%.2f\n", ns[0], ns[1], ns[2]);
+  TIME(libmLogistic, inputs, outputs, ns[0]);
+  TIME(fastLogistic, inputs, outputs, ns[1]);
+  TIME(fasterLogistic, inputs, outputs, ns[2]);
+  printf("logistic\t%.2f\t%.2f\t%.2f\n", ns[0], ns[1], ns[2]);
+  free(inputs);
+  free(outputs);
+}
+
+// train a network from the same starting weights with each accuracy
+// hidden is the rest of the command line initNN gets, after the accuracy
+static void measureTraining(const char *name, char *file, int epochs, int hiddenCount, char **hidden) {
+  static char *accuracies[] = {"exact", "fast", "faster"};
+  int a, i;
+  printf("%s\tmse\tseconds\n", name);
+  for (a = 0; a < 3; a++) {
+    char *argv[16];
+    int argc = 0;
+    double mse = 0.0;
+    clock_t start;
+    argv[argc++] = "fastmathbench";
+    argv[argc++] = "-a";
+    argv[argc++] = accuracies[a];
+    argv[argc++] = "-s";
+    argv[argc++] = "1";
+    // cluster every time instead of leaving centers next to the data
+    argv[argc++] = "-n";
+    argv[argc++] = "-f";
+    argv[argc++] = file;
+    for (i = 0; i < hiddenCount; i++) {
+      argv[argc++] = hidden[i];
+    }
+    initNN(&argc, argv);
+    start = clock();
+    for (i = 0; i < epochs; i++) {
+      mse = learn();
+    }
+    printf("%s\t%.10f\t%.2f\n", accuracies[a], mse, (double)(clock() - start) / CLOCKS_PER_SEC);
+    freeNN();
+  }
+}
+
+int main(int argc, char **argv) {
+  char *file = argc > 1 ? argv[1] : "spiral.dat";
+  int epochs = argc > 2 ? atoi(argv[2]) : 500;
+  char *mlp[] = {"10", "10"};
+  char *rbf[] = {"-r", "30", "10"};
+  initFastMath();
+  measureError();
+  measureSpeed();
+  measureTraining("mlp 10 10", file, epochs, 2, mlp);
+  measureTraining("rbf 30 10", file, epochs, 3, rbf);
+  return 0;
+}
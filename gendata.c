@@ -0,0 +1,94 @@
+/*\
+ * Homework 2 - a neural network with a real-time preview
+ * Copyright (C) 2010 Matthew Donoughe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRENTY; without even the implied warrenty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. Tee the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Pubilc License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+\*/
+
+// generates big training sets
+// gendata <spiral|circles|checkerboard|xor> <inputs> <file> [noise [seed]]
+// writes the binary format when file ends in .bin and "X\tY\tTARGET" lines
+// otherwise, a chunk at a time so the set never has to fit in memory
+// see synth.h for the shapes and the noise
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dataset.h"
+#include "rng.h"
+#include "synth.h"
+
+// how many inputs are generated and written at once
+#define CHUNK_SIZE 1048576
+
+int main(int argc, char **argv) {
+  SynthShape shape;
+  unsigned long long size;
+  double noise = argc > 4 ? atof(argv[4]) : 0.0;
+  unsigned long long seed = argc > 5 ? strtoull(argv[5], NULL, 10) : 1;
+  size_t length;
+  int binary;
+  DatasetStream stream;
+  FILE *text = NULL;
+  Dataset chunk;
+  Rng rng;
+  unsigned int first, i;
+  int ok;
+  if (argc < 4 || argc > 6 || !findSynthShape(argv[1], &shape)) {
+    fprintf(stderr, "usage: %s <spiral|circles|checkerboard|xor> <inputs> <file> [noise [seed]]\n", argv[0]);
+    return 1;
+  }
+  size = strtoull(argv[2], NULL, 10);
+  if (size != (unsigned int)size) {
+    fprintf(stderr, "Can't make more than %u inputs.\n", (unsigned int)-1);
+    return 1;
+  }
+  length = strlen(argv[3]);
+  binary = length >= 4 && !strcmp(argv[3] + length - 4, ".bin");
+  if (binary)
+    ok = createBinaryDataset(&stream, argv[3], size);
+  else
+    ok = (text = fopen(argv[3], "w")) != NULL;
+  if (!ok) {
+    fprintf(stderr, "Can't write %s.\n", argv[3]);
+    return 1;
+  }
+  seedRng(&rng, seed, 0);
+  allocateDataset(&chunk, CHUNK_SIZE);
+  for (first = 0; ok && first < size; first += chunk.size) {
+    synthesize(&chunk, size - first < CHUNK_SIZE ? size - first : CHUNK_SIZE, shape, noise, &rng);
+    if (binary) {
+      ok = writeDatasetBlock(&stream, &chunk, first);
+    } else {
+      for (i = 0; ok && i < chunk.size; i++) {
+        // 9 digits is enough to get the same float back
+        ok = fprintf(text, "%.9g\t%.9g\t%d\n", chunk.x[i], chunk.y[i], chunk.target[i] > 0) > 0;
+      }
+    }
+  }
+  freeDataset(&chunk);
+  if (binary)
+    ok = closeDatasetStream(&stream) && ok;
+  else
+    ok = fclose(text) == 0 && ok;
+  if (!ok) {
+    // don't leave half a set to be trained on later
+    remove(argv[3]);
+    fprintf(stderr, "Can't write %s.\n", argv[3]);
+    return 1;
+  }
+  printf("%llu inputs written to %s\n", size, argv[3]);
+  return 0;
+}
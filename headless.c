@@ -0,0 +1,95 @@
+/*\
+ * Homework 2 - a neural network with a real-time preview
+ * Copyright (C) 2010 Matthew Donoughe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRENTY; without even the implied warrenty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. Tee the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Pubilc License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+\*/
+
+// trains without a window, for machines with no display or OpenGL
+// homework2-headless [-e epochs] [-T seconds] [-g mse] [-q] [homework2 options]
+//   [hidden layer sizes]
+// stops after the epochs or the seconds, whichever comes first(1000 epochs
+// without either), or as soon as the mse gets down to the goal, and prints each
+// epoch's mse like homework2 unless -q leaves just the last one
+// exits with 0 when it stopped because of the budget or reached the goal, 1 if
+// it couldn't start(like when the training set can't be read or has no
+// inputs), 2 if it used up the budget without reaching the goal, and 3 if the
+// mse stopped being a number
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main.h"
+#include "nn.h"
+
+#define EXIT_DONE 0
+#define EXIT_MISSED_GOAL 2
+#define EXIT_DIVERGED 3
+
+GLData glData;
+NNData nnData;
+
+int main(int argc, char **argv) {
+  unsigned int epochs = 0;
+  double seconds = 0.0;
+  double goal = -1.0;
+  int quiet = 0;
+  // wall clock, since clock() adds up every training thread
+  unsigned long long start;
+  double mse;
+
+  // these options come first, initNN handles the rest
+  while (argc > 1 && argv[1][0] == '-') {
+    if (argc > 2 && !strcmp(argv[1], "-e")) {
+      epochs = strtoul(argv[2], NULL, 10);
+      consumeArguments(&argc, argv, 2);
+    } else if (argc > 2 && !strcmp(argv[1], "-T")) {
+      seconds = atof(argv[2]);
+      consumeArguments(&argc, argv, 2);
+    } else if (argc > 2 && !strcmp(argv[1], "-g")) {
+      goal = atof(argv[2]);
+      consumeArguments(&argc, argv, 2);
+    } else if (!strcmp(argv[1], "-q")) {
+      quiet = 1;
+      consumeArguments(&argc, argv, 1);
+    } else {
+      break;
+    }
+  }
+  // without any budget it would never stop short of the goal
+  if (epochs == 0 && seconds <= 0.0)
+    epochs = 1000;
+
+  initNN(&argc, argv);
+
+  start = profileNow();
+  for (;;) {
+    mse = learn();
+    if (!quiet) {
+      printf("%d\t%f\n", nnData.epoch, mse);
+      reportProfile();
+    }
+    if (mse != mse)
+      break;
+    if (mse <= goal || (epochs > 0 && nnData.epoch >= epochs) || (seconds > 0.0 && (profileNow() - start) / 1e9 >= seconds))
+      break;
+  }
+  printf("%d epochs\t%f mse\t%.3f seconds\n", nnData.epoch, mse, (profileNow() - start) / 1e9);
+  if (mse != mse)
+    return EXIT_DIVERGED;
+  if (goal >= 0.0 && mse > goal)
+    return EXIT_MISSED_GOAL;
+  return EXIT_DONE;
+}
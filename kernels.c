@@ -0,0 +1,343 @@
+/*\
+ * Homework 2 - a neural network with a real-time preview
+ * Copyright (C) 2010 Matthew Donoughe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRENTY; without even the implied warrenty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. Tee the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Pubilc License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+\*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "main.h"
+#include "kernels.h"
+
+// figure out which vector kernels this compiler can build
+// the ppc build only gets the scalar kernels
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#define HAVE_SSE2
+#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))) || (defined(_MSC_VER) && _MSC_VER >= 1800)
+#define HAVE_AVX2
+#endif
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5) || (defined(_MSC_VER) && _MSC_VER >= 1912)
+#define HAVE_AVX512
+#endif
+#endif
+
+#ifdef HAVE_SSE2
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#ifdef HAVE_AVX2
+#include <immintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+#endif
+
+// gcc and clang need to be told which functions may use which instructions
+// msvc lets any function use any intrinsic
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET(isa) __attribute__((target(isa)))
+#else
+#define TARGET(isa)
+#endif
+
+Kernels kernels;
+
+static NNFloat dot_scalar(const GLfloat *weights, const NNFloat *values, int n) {
+  NNFloat sum = 0.0;
+  int i;
+  for (i = 0; i < n; i++) {
+    sum += weights[i] * values[i];
+  }
+  return sum;
+}
+
+static void dot4_scalar(const GLfloat *weights, const NNFloat *values0, const NNFloat *values1, const NNFloat *values2, const NNFloat *values3, int n, NNFloat *sums) {
+  NNFloat sum0 = 0.0;
+  NNFloat sum1 = 0.0;
+  NNFloat sum2 = 0.0;
+  NNFloat sum3 = 0.0;
+  int i;
+  for (i = 0; i < n; i++) {
+    sum0 += weights[i] * values0[i];
+    sum1 += weights[i] * values1[i];
+    sum2 += weights[i] * values2[i];
+    sum3 += weights[i] * values3[i];
+  }
+  sums[0] = sum0;
+  sums[1] = sum1;
+  sums[2] = sum2;
+  sums[3] = sum3;
+}
+
+static void backpropagate_scalar(NNFloat *errors, const GLfloat *weights, NNFloat error, int n) {
+  int i;
+  for (i = 0; i < n; i++) {
+    errors[i] += weights[i] * error;
+  }
+}
+
+static void accumulate_scalar(NNFloat *gradients, const NNFloat *values, NNFloat delta, int n) {
+  int i;
+  for (i = 0; i < n; i++) {
+    gradients[i] += delta * values[i];
+  }
+}
+
+static void update_scalar(GLfloat *weights, NNFloat *momentums, const NNFloat *values, NNFloat delta, NNFloat momentum, int n) {
+  int i;
+  for (i = 0; i < n; i++) {
+    momentums[i] = delta * values[i] + momentum * momentums[i];
+    weights[i] += momentums[i];
+  }
+}
+
+#ifdef HAVE_SSE2
+#define KERNEL(name) name##_sse2
+#define KERNEL_TARGET TARGET("sse2")
+#ifdef SINGLE_PRECISION
+TARGET("sse2") static float hsum_sse2(__m128 v) {
+  v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+  return _mm_cvtss_f32(_mm_add_ss(v, _mm_shuffle_ps(v, v, 1)));
+}
+
+#define WIDTH 4
+#define VECTOR __m128
+#define LOAD_WEIGHTS(p) _mm_loadu_ps(p)
+#define STORE_WEIGHTS(p, v) _mm_storeu_ps((p), (v))
+#define LOAD(p) _mm_loadu_ps(p)
+#define STORE(p, v) _mm_storeu_ps((p), (v))
+#define SET1(x) _mm_set1_ps(x)
+#define ZERO() _mm_setzero_ps()
+#define ADD(a, b) _mm_add_ps((a), (b))
+#define MUL(a, b) _mm_mul_ps((a), (b))
+#define HSUM(v) hsum_sse2(v)
+#else
+TARGET("sse2") static double hsum_sse2(__m128d v) {
+  return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+// two doubles per register, so weights are loaded two floats at a time
+#define WIDTH 2
+#define VECTOR __m128d
+#define LOAD_WEIGHTS(p) _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64((const __m128i *)(p))))
+#define STORE_WEIGHTS(p, v) _mm_storel_epi64((__m128i *)(p), _mm_castps_si128(_mm_cvtpd_ps(v)))
+#define LOAD(p) _mm_loadu_pd(p)
+#define STORE(p, v) _mm_storeu_pd((p), (v))
+#define SET1(x) _mm_set1_pd(x)
+#define ZERO() _mm_setzero_pd()
+#define ADD(a, b) _mm_add_pd((a), (b))
+#define MUL(a, b) _mm_mul_pd((a), (b))
+#define HSUM(v) hsum_sse2(v)
+#endif
+// no fused multiply add before avx2
+#define MULADD(a, b, c) ADD(MUL((a), (b)), (c))
+#include "kerneltemplate.h"
+#endif
+
+#ifdef HAVE_AVX2
+#define KERNEL(name) name##_avx2
+#define KERNEL_TARGET TARGET("avx2,fma")
+#ifdef SINGLE_PRECISION
+TARGET("avx2,fma") static float hsum_avx2(__m256 v) {
+  __m128 half = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+  return _mm_cvtss_f32(_mm_add_ss(half, _mm_shuffle_ps(half, half, 1)));
+}
+
+#define WIDTH 8
+#define VECTOR __m256
+#define LOAD_WEIGHTS(p) _mm256_loadu_ps(p)
+#define STORE_WEIGHTS(p, v) _mm256_storeu_ps((p), (v))
+#define LOAD(p) _mm256_loadu_ps(p)
+#define STORE(p, v) _mm256_storeu_ps((p), (v))
+#define SET1(x) _mm256_set1_ps(x)
+#define ZERO() _mm256_setzero_ps()
+#define ADD(a, b) _mm256_add_ps((a), (b))
+#define MUL(a, b) _mm256_mul_ps((a), (b))
+#define MULADD(a, b, c) _mm256_fmadd_ps((a), (b), (c))
+#define HSUM(v) hsum_avx2(v)
+#else
+TARGET("avx2,fma") static double hsum_avx2(__m256d v) {
+  __m128d half = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+}
+
+#define WIDTH 4
+#define VECTOR __m256d
+#define LOAD_WEIGHTS(p) _mm256_cvtps_pd(_mm_loadu_ps(p))
+#define STORE_WEIGHTS(p, v) _mm_storeu_ps((p), _mm256_cvtpd_ps(v))
+#define LOAD(p) _mm256_loadu_pd(p)
+#define STORE(p, v) _mm256_storeu_pd((p), (v))
+#define SET1(x) _mm256_set1_pd(x)
+#define ZERO() _mm256_setzero_pd()
+#define ADD(a, b) _mm256_add_pd((a), (b))
+#define MUL(a, b) _mm256_mul_pd((a), (b))
+#define MULADD(a, b, c) _mm256_fmadd_pd((a), (b), (c))
+#define HSUM(v) hsum_avx2(v)
+#endif
+#include "kerneltemplate.h"
+#endif
+
+#ifdef HAVE_AVX512
+#define KERNEL(name) name##_avx512
+#define KERNEL_TARGET TARGET("avx512f")
+#ifdef SINGLE_PRECISION
+TARGET("avx512f") static float hsum_avx512(__m512 v) {
+  // avx512f can only pull out the top half as doubles
+  __m256 quarter = _mm256_add_ps(_mm512_castps512_ps256(v), _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1)));
+  __m128 half = _mm_add_ps(_mm256_castps256_ps128(quarter), _mm256_extractf128_ps(quarter, 1));
+  half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+  return _mm_cvtss_f32(_mm_add_ss(half, _mm_shuffle_ps(half, half, 1)));
+}
+
+#define WIDTH 16
+#define VECTOR __m512
+#define LOAD_WEIGHTS(p) _mm512_loadu_ps(p)
+#define STORE_WEIGHTS(p, v) _mm512_storeu_ps((p), (v))
+#define LOAD(p) _mm512_loadu_ps(p)
+#define STORE(p, v) _mm512_storeu_ps((p), (v))
+#define SET1(x) _mm512_set1_ps(x)
+#define ZERO() _mm512_setzero_ps()
+#define ADD(a, b) _mm512_add_ps((a), (b))
+#define MUL(a, b) _mm512_mul_ps((a), (b))
+#define MULADD(a, b, c) _mm512_fmadd_ps((a), (b), (c))
+#define HSUM(v) hsum_avx512(v)
+#else
+TARGET("avx512f") static double hsum_avx512(__m512d v) {
+  __m256d quarter = _mm256_add_pd(_mm512_castpd512_pd256(v), _mm512_extractf64x4_pd(v, 1));
+  __m128d half = _mm_add_pd(_mm256_castpd256_pd128(quarter), _mm256_extractf128_pd(quarter, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+}
+
+#define WIDTH 8
+#define VECTOR __m512d
+#define LOAD_WEIGHTS(p) _mm512_cvtps_pd(_mm256_loadu_ps(p))
+#define STORE_WEIGHTS(p, v) _mm256_storeu_ps((p), _mm512_cvtpd_ps(v))
+#define LOAD(p) _mm512_loadu_pd(p)
+#define STORE(p, v) _mm512_storeu_pd((p), (v))
+#define SET1(x) _mm512_set1_pd(x)
+#define ZERO() _mm512_setzero_pd()
+#define ADD(a, b) _mm512_add_pd((a), (b))
+#define MUL(a, b) _mm512_mul_pd((a), (b))
+#define MULADD(a, b, c) _mm512_fmadd_pd((a), (b), (c))
+#define HSUM(v) hsum_avx512(v)
+#endif
+#include "kerneltemplate.h"
+#endif
+
+static const Kernels scalarKernels = {"scalar", &dot_scalar, &dot4_scalar, &backpropagate_scalar, &accumulate_scalar, &update_scalar};
+#ifdef HAVE_SSE2
+static const Kernels sse2Kernels = {"sse2", &dot_sse2, &dot4_sse2, &backpropagate_sse2, &accumulate_sse2, &update_sse2};
+#endif
+#ifdef HAVE_AVX2
+static const Kernels avx2Kernels = {"avx2", &dot_avx2, &dot4_avx2, &backpropagate_avx2, &accumulate_avx2, &update_avx2};
+#endif
+#ifdef HAVE_AVX512
+static const Kernels avx512Kernels = {"avx512", &dot_avx512, &dot4_avx512, &backpropagate_avx512, &accumulate_avx512, &update_avx512};
+#endif
+
+#ifdef HAVE_SSE2
+static void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int *regs) {
+#ifdef _MSC_VER
+  __cpuidex((int *)regs, leaf, subleaf);
+#else
+  __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// which register states the os saves on a context switch
+static unsigned long long xgetbv() {
+#ifdef _MSC_VER
+  return _xgetbv(0);
+#else
+  unsigned int eax, edx;
+  __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+#endif
+
+// the widest kernels this cpu and os can run
+static const Kernels *widestKernels() {
+#ifdef HAVE_SSE2
+  unsigned int regs[4];
+  unsigned int maxLeaf;
+  unsigned long long xcr0 = 0;
+  cpuid(0, 0, regs);
+  maxLeaf = regs[0];
+  cpuid(1, 0, regs);
+  // sse2 is edx bit 26
+  if (!(regs[3] & (1 << 26)))
+    return &scalarKernels;
+  // avx needs osxsave(ecx bit 27) and the os saving the ymm registers
+  if ((regs[2] & (1 << 27)) && maxLeaf >= 7) {
+    unsigned int fma = regs[2] & (1 << 12);
+    xcr0 = xgetbv();
+    cpuid(7, 0, regs);
+#ifdef HAVE_AVX512
+    // avx512f is ebx bit 16, and the os must also save the opmask and zmm registers
+    if ((regs[1] & (1 << 16)) && (xcr0 & 0xe6) == 0xe6)
+      return &avx512Kernels;
+#endif
+#ifdef HAVE_AVX2
+    // avx2 is ebx bit 5
+    if ((regs[1] & (1 << 5)) && fma && (xcr0 & 0x6) == 0x6)
+      return &avx2Kernels;
+#endif
+  }
+  return &sse2Kernels;
+#else
+  return &scalarKernels;
+#endif
+}
+
+int selectKernels(const char *name) {
+  const Kernels *widest = widestKernels();
+  if (name == NULL) {
+    kernels = *widest;
+    return 1;
+  }
+  if (!strcmp(name, "scalar")) {
+    kernels = scalarKernels;
+    return 1;
+  }
+#ifdef HAVE_SSE2
+  // anything narrower than the widest supported set is fine too
+  if (!strcmp(name, "sse2") && widest != &scalarKernels) {
+    kernels = sse2Kernels;
+    return 1;
+  }
+#endif
+#ifdef HAVE_AVX2
+  if (!strcmp(name, "avx2") && (widest == &avx2Kernels
+#ifdef HAVE_AVX512
+      || widest == &avx512Kernels
+#endif
+      )) {
+    kernels = avx2Kernels;
+    return 1;
+  }
+#endif
+#ifdef HAVE_AVX512
+  if (!strcmp(name, "avx512") && widest == &avx512Kernels) {
+    kernels = avx512Kernels;
+    return 1;
+  }
+#endif
+  return 0;
+}
@@ -0,0 +1,37 @@
+// the inner loops of learn(), with a scalar version and vector versions for
+// x86 picked by cpuid at startup
+//
+// the scalar kernels do exactly what the loops in learn() used to do. The
+// vector kernels do the same arithmetic on several elements at once, so:
+// - backpropagate, accumulate, and update work element by element and only
+//   differ from the scalar kernels where the avx2 and avx512 kernels fuse a
+//   multiply and an add, which is at most 1 ulp per element
+// - dot and dot4 add their products in a different order, so a sum of n
+//   products may differ from the scalar one by up to n * epsilon times the
+//   sum of the absolute values of the products, where epsilon is 2^-52, or
+//   2^-23 with SINGLE_PRECISION
+// training is chaotic enough that two runs with different kernels drift apart
+// over many epochs, but they drift apart the same way two runs with different
+// seeds do, not in how well they learn
+typedef struct Kernels {
+  // scalar, sse2, avx2, or avx512
+  const char *name;
+  // sum of weights[i] * values[i]
+  NNFloat (*dot)(const GLfloat *weights, const NNFloat *values, int n);
+  // dot for four sets of values at once, sharing the weights
+  void (*dot4)(const GLfloat *weights, const NNFloat *values0, const NNFloat *values1, const NNFloat *values2, const NNFloat *values3, int n, NNFloat *sums);
+  // errors[i] += weights[i] * error
+  void (*backpropagate)(NNFloat *errors, const GLfloat *weights, NNFloat error, int n);
+  // gradients[i] += delta * values[i]
+  void (*accumulate)(NNFloat *gradients, const NNFloat *values, NNFloat delta, int n);
+  // momentums[i] = delta * values[i] + momentum * momentums[i]
+  // weights[i] += momentums[i]
+  void (*update)(GLfloat *weights, NNFloat *momentums, const NNFloat *values, NNFloat delta, NNFloat momentum, int n);
+} Kernels;
+
+// the kernels learn() uses
+extern Kernels kernels;
+
+// choose the kernels by name, or the widest ones this cpu supports for NULL
+// returns 0 if the named kernels are unknown or unsupported
+int selectKernels(const char *name);
@@ -0,0 +1,111 @@
+// the body of the vector kernels
+// kernels.c includes this once per instruction set after defining:
+// KERNEL(name)            the name of the kernel for this instruction set
+// KERNEL_TARGET           what the compiler needs to be told to allow them
+// WIDTH                   how many NNFloats fit in a VECTOR
+// VECTOR                  the vector type
+// LOAD_WEIGHTS(p)         load WIDTH weights as NNFloats
+// STORE_WEIGHTS(p, v)     store WIDTH NNFloats as weights
+// LOAD(p), STORE(p, v)    load and store WIDTH NNFloats
+// SET1(x), ZERO()         make a vector with the same value everywhere
+// ADD(a, b), MUL(a, b)    elementwise arithmetic
+// MULADD(a, b, c)         a * b + c, fused when the instruction set can
+// HSUM(v)                 add up the elements of a vector
+// and it undefines all of them when it's done
+
+KERNEL_TARGET static NNFloat KERNEL(dot)(const GLfloat *weights, const NNFloat *values, int n) {
+  VECTOR sum0 = ZERO();
+  VECTOR sum1 = ZERO();
+  NNFloat sum;
+  int i;
+  for (i = 0; i + 2 * WIDTH <= n; i += 2 * WIDTH) {
+    sum0 = MULADD(LOAD_WEIGHTS(weights + i), LOAD(values + i), sum0);
+    sum1 = MULADD(LOAD_WEIGHTS(weights + i + WIDTH), LOAD(values + i + WIDTH), sum1);
+  }
+  if (i + WIDTH <= n) {
+    sum0 = MULADD(LOAD_WEIGHTS(weights + i), LOAD(values + i), sum0);
+    i += WIDTH;
+  }
+  sum = HSUM(ADD(sum0, sum1));
+  for (; i < n; i++) {
+    sum += weights[i] * values[i];
+  }
+  return sum;
+}
+
+KERNEL_TARGET static void KERNEL(dot4)(const GLfloat *weights, const NNFloat *values0, const NNFloat *values1, const NNFloat *values2, const NNFloat *values3, int n, NNFloat *sums) {
+  VECTOR sum0 = ZERO();
+  VECTOR sum1 = ZERO();
+  VECTOR sum2 = ZERO();
+  VECTOR sum3 = ZERO();
+  int i;
+  for (i = 0; i + WIDTH <= n; i += WIDTH) {
+    VECTOR w = LOAD_WEIGHTS(weights + i);
+    sum0 = MULADD(w, LOAD(values0 + i), sum0);
+    sum1 = MULADD(w, LOAD(values1 + i), sum1);
+    sum2 = MULADD(w, LOAD(values2 + i), sum2);
+    sum3 = MULADD(w, LOAD(values3 + i), sum3);
+  }
+  sums[0] = HSUM(sum0);
+  sums[1] = HSUM(sum1);
+  sums[2] = HSUM(sum2);
+  sums[3] = HSUM(sum3);
+  for (; i < n; i++) {
+    sums[0] += weights[i] * values0[i];
+    sums[1] += weights[i] * values1[i];
+    sums[2] += weights[i] * values2[i];
+    sums[3] += weights[i] * values3[i];
+  }
+}
+
+KERNEL_TARGET static void KERNEL(backpropagate)(NNFloat *errors, const GLfloat *weights, NNFloat error, int n) {
+  VECTOR e = SET1(error);
+  int i;
+  for (i = 0; i + WIDTH <= n; i += WIDTH) {
+    STORE(errors + i, MULADD(LOAD_WEIGHTS(weights + i), e, LOAD(errors + i)));
+  }
+  for (; i < n; i++) {
+    errors[i] += weights[i] * error;
+  }
+}
+
+KERNEL_TARGET static void KERNEL(accumulate)(NNFloat *gradients, const NNFloat *values, NNFloat delta, int n) {
+  VECTOR d = SET1(delta);
+  int i;
+  for (i = 0; i + WIDTH <= n; i += WIDTH) {
+    STORE(gradients + i, MULADD(d, LOAD(values + i), LOAD(gradients + i)));
+  }
+  for (; i < n; i++) {
+    gradients[i] += delta * values[i];
+  }
+}
+
+KERNEL_TARGET static void KERNEL(update)(GLfloat *weights, NNFloat *momentums, const NNFloat *values, NNFloat delta, NNFloat momentum, int n) {
+  VECTOR d = SET1(delta);
+  VECTOR m = SET1(momentum);
+  int i;
+  for (i = 0; i + WIDTH <= n; i += WIDTH) {
+    VECTOR newMomentums = MULADD(d, LOAD(values + i), MUL(m, LOAD(momentums + i)));
+    STORE(momentums + i, newMomentums);
+    STORE_WEIGHTS(weights + i, ADD(LOAD_WEIGHTS(weights + i), newMomentums));
+  }
+  for (; i < n; i++) {
+    momentums[i] = delta * values[i] + momentum * momentums[i];
+    weights[i] += momentums[i];
+  }
+}
+
+#undef KERNEL
+#undef KERNEL_TARGET
+#undef WIDTH
+#undef VECTOR
+#undef LOAD_WEIGHTS
+#undef STORE_WEIGHTS
+#undef LOAD
+#undef STORE
+#undef SET1
+#undef ZERO
+#undef ADD
+#undef MUL
+#undef MULADD
+#undef HSUM
@@ -0,0 +1,760 @@
+/*\
+ * Homework 2 - a neural network with a real-time preview
+ * Copyright (C) 2010 Matthew Donoughe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRENTY; without even the implied warrenty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. Tee the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Pubilc License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+\*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "kmeans.h"
+
+// inputs are handed out to the threads this many at a time
+#define BLOCK_SIZE 4096
+// but there are never more blocks than this, so big training sets don't need
+// piles of accumulators
+#define MAX_BLOCKS 256
+
+// everything the threads share during kmeans
+typedef struct KMeans {
+  float *centers;
+  int stride;
+  int count;
+  const Dataset *data;
+  KMeansAlgorithm algorithm;
+  // the center each input belongs to
+  int *assignments;
+
+  // for hamerly
+  // the upper bound on the distance from each input to its center and the
+  // lower bound on the distance to every other center
+  double *upper;
+  double *lower;
+  // half the distance from each center to the closest other center
+  double *halfGap;
+  // how far each center moved in the last iteration, the one that moved the
+  // farthest, and how far the second farthest moved
+  double *moved;
+  int farthest;
+  double secondMoved;
+
+  // the inputs are split into blocks of blockSize
+  unsigned int blocks;
+  unsigned int blockSize;
+  // each block's sums of x and y for every center, then its squared distances
+  double *blockSums;
+  // each block's number of inputs for every center
+  unsigned int *blockAssigned;
+  // whether any input in the block changed centers
+  char *blockChanged;
+
+  // the number of centers nothing was closest to in the last pass
+  int empty;
+  // the inputs furthest from their centers in each block, empty of them, and
+  // how far away they are, furthest first
+  unsigned int *blockFarthest;
+  double *blockFarthestDistances;
+  // the same for all the blocks together, where the empty centers go
+  unsigned int *reseeds;
+  double *reseedDistances;
+  Pool *pool;
+} KMeans;
+
+// the inputs are cut into blocks that only depend on how many there are, so
+// the blocks are added up the same way for any number of threads
+static void splitBlocks(unsigned int size, unsigned int *blocks, unsigned int *blockSize) {
+  *blocks = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  *blocks = *blocks > MAX_BLOCKS ? MAX_BLOCKS : (*blocks < 1 ? 1 : *blocks);
+  *blockSize = (size + *blocks - 1) / *blocks;
+}
+
+// the index just past the end of a block
+static unsigned int blockEnd(unsigned int block, unsigned int blockSize, unsigned int size) {
+  unsigned int end = (block + 1) * blockSize;
+  return end > size ? size : end;
+}
+
+// add an input to a list of count inputs kept furthest first, if it's further
+// than the last one
+// ties keep the input that was added first
+static void keepFarthest(unsigned int *inputs, double *distances, int count, unsigned int input, double distance) {
+  int j;
+  if (distance <= distances[count - 1])
+    return;
+  for (j = count - 1; j > 0 && distance > distances[j - 1]; j--) {
+    inputs[j] = inputs[j - 1];
+    distances[j] = distances[j - 1];
+  }
+  inputs[j] = input;
+  distances[j] = distance;
+}
+
+// squared distance from an input to a center
+static double distance2(const Dataset *data, unsigned int i, const float *center) {
+  double dx = data->x[i] - center[0];
+  double dy = data->y[i] - center[1];
+  return dx * dx + dy * dy;
+}
+
+// the closest center to an input, and how far away the closest and the
+// second closest are
+static int closestCenter(const KMeans *k, unsigned int i, double *distance, double *secondDistance) {
+  int closest = 0;
+  int j;
+  *distance = distance2(k->data, i, k->centers);
+  *secondDistance = HUGE_VAL;
+  for (j = 1; j < k->count; j++) {
+    double ndistance = distance2(k->data, i, k->centers + j * k->stride);
+    if (ndistance < *distance) {
+      *secondDistance = *distance;
+      closest = j;
+      *distance = ndistance;
+    } else if (ndistance < *secondDistance) {
+      *secondDistance = ndistance;
+    }
+  }
+  return closest;
+}
+
+// lloyd finds the closest center to every input, every time
+static int assignLloyd(KMeans *k, unsigned int i) {
+  double distance, secondDistance;
+  return closestCenter(k, i, &distance, &secondDistance);
+}
+
+// Hamerly, "Making k-means even faster", SDM 2010
+// every input keeps an upper bound on the distance to its center and a lower
+// bound on the distance to every other center. When the upper bound is below
+// the lower bound, or below half the distance from its center to the next
+// closest center, the input can't have changed centers and no distances
+// need computing. When centers move the bounds loosen by how far they moved
+static int assignHamerly(KMeans *k, unsigned int i) {
+  int assignment = k->assignments[i];
+  double bound;
+  double distance, secondDistance;
+  int closest;
+  // loosen the bounds by how far the centers went
+  k->upper[i] += k->moved[assignment];
+  k->lower[i] -= assignment == k->farthest ? k->secondMoved : k->moved[k->farthest];
+  bound = k->halfGap[assignment] > k->lower[i] ? k->halfGap[assignment] : k->lower[i];
+  if (k->upper[i] <= bound)
+    return assignment;
+  // tighten the upper bound and try again
+  k->upper[i] = sqrt(distance2(k->data, i, k->centers + assignment * k->stride));
+  if (k->upper[i] <= bound)
+    return assignment;
+  // no luck, look at every center the way lloyd does
+  closest = closestCenter(k, i, &distance, &secondDistance);
+  k->upper[i] = sqrt(distance);
+  k->lower[i] = sqrt(secondDistance);
+  return closest;
+}
+
+// assign every input in the thread's blocks and add them up by center
+static void assignBlocks(unsigned int thread, void *arg) {
+  KMeans *k = (KMeans *)arg;
+  unsigned int block;
+  for (block = thread; block < k->blocks; block += k->pool->threads) {
+    double *sums = k->blockSums + 2 * k->count * block;
+    unsigned int *assigned = k->blockAssigned + k->count * block;
+    unsigned int end = blockEnd(block, k->blockSize, k->data->size);
+    unsigned int i;
+    char changed = 0;
+    memset(sums, 0, 2 * k->count * sizeof(double));
+    memset(assigned, 0, k->count * sizeof(unsigned int));
+    for (i = block * k->blockSize; i < end; i++) {
+      int closest = k->algorithm == KMEANS_HAMERLY ? assignHamerly(k, i) : assignLloyd(k, i);
+      changed |= k->assignments[i] != closest;
+      k->assignments[i] = closest;
+      sums[2 * closest] += k->data->x[i];
+      sums[2 * closest + 1] += k->data->y[i];
+      assigned[closest]++;
+    }
+    k->blockChanged[block] = changed;
+  }
+}
+
+// add up the squared distances from the inputs in the thread's blocks to
+// their centers
+static void addVariances(unsigned int thread, void *arg) {
+  KMeans *k = (KMeans *)arg;
+  unsigned int block;
+  for (block = thread; block < k->blocks; block += k->pool->threads) {
+    double *sums = k->blockSums + 2 * k->count * block;
+    unsigned int end = blockEnd(block, k->blockSize, k->data->size);
+    unsigned int i;
+    memset(sums, 0, k->count * sizeof(double));
+    for (i = block * k->blockSize; i < end; i++) {
+      sums[k->assignments[i]] += distance2(k->data, i, k->centers + k->assignments[i] * k->stride);
+    }
+  }
+}
+
+// find the inputs in the thread's blocks that are furthest from their centers
+static void findFarthest(unsigned int thread, void *arg) {
+  KMeans *k = (KMeans *)arg;
+  unsigned int block;
+  for (block = thread; block < k->blocks; block += k->pool->threads) {
+    unsigned int *inputs = k->blockFarthest + k->count * block;
+    double *distances = k->blockFarthestDistances + k->count * block;
+    unsigned int end = blockEnd(block, k->blockSize, k->data->size);
+    unsigned int i;
+    int j;
+    for (j = 0; j < k->empty; j++) {
+      distances[j] = 0.0;
+    }
+    for (i = block * k->blockSize; i < end; i++) {
+      keepFarthest(inputs, distances, k->empty, i, distance2(k->data, i, k->centers + k->assignments[i] * k->stride));
+    }
+  }
+}
+
+// find half the distance from every center to its closest neighbor
+static void findGaps(KMeans *k) {
+  int i, j;
+  for (i = 0; i < k->count; i++) {
+    k->halfGap[i] = HUGE_VAL;
+    for (j = 0; j < k->count; j++) {
+      if (j != i) {
+        double dx = k->centers[i * k->stride] - k->centers[j * k->stride];
+        double dy = k->centers[i * k->stride + 1] - k->centers[j * k->stride + 1];
+        double gap = dx * dx + dy * dy;
+        if (gap < k->halfGap[i])
+          k->halfGap[i] = gap;
+      }
+    }
+    k->halfGap[i] = 0.5 * sqrt(k->halfGap[i]);
+  }
+}
+
+// move every center to the mean of its inputs, adding up the blocks in order
+// returns 1 if no input changed centers
+static int moveCenters(KMeans *k, double *sums, unsigned int *assigned) {
+  unsigned int block;
+  int j;
+  int done = 1;
+  memset(sums, 0, 2 * k->count * sizeof(double));
+  memset(assigned, 0, k->count * sizeof(unsigned int));
+  for (block = 0; block < k->blocks; block++) {
+    for (j = 0; j < 2 * k->count; j++) {
+      sums[j] += k->blockSums[2 * k->count * block + j];
+    }
+    for (j = 0; j < k->count; j++) {
+      assigned[j] += k->blockAssigned[k->count * block + j];
+    }
+    done &= !k->blockChanged[block];
+  }
+  // a center nothing is closest to has no mean, so it's moved onto one of the
+  // inputs furthest from their centers instead, which takes it away from them
+  // and always makes the clusters tighter
+  k->empty = 0;
+  for (j = 0; j < k->count; j++) {
+    k->empty += assigned[j] == 0;
+  }
+  if (k->empty > 0) {
+    runPool(k->pool, &findFarthest, k);
+    for (j = 0; j < k->empty; j++) {
+      k->reseedDistances[j] = 0.0;
+    }
+    for (block = 0; block < k->blocks; block++) {
+      for (j = 0; j < k->empty; j++) {
+        keepFarthest(k->reseeds, k->reseedDistances, k->empty, k->blockFarthest[k->count * block + j], k->blockFarthestDistances[k->count * block + j]);
+      }
+    }
+  }
+  k->farthest = 0;
+  k->empty = 0;
+  for (j = 0; j < k->count; j++) {
+    float oldX = k->centers[j * k->stride];
+    float oldY = k->centers[j * k->stride + 1];
+    if (assigned[j] > 0) {
+      k->centers[j * k->stride] = sums[2 * j] / assigned[j];
+      k->centers[j * k->stride + 1] = sums[2 * j + 1] / assigned[j];
+    } else if (k->reseedDistances[k->empty] > 0.0) {
+      // every input sitting right on a center would leave it where it is
+      k->centers[j * k->stride] = k->data->x[k->reseeds[k->empty]];
+      k->centers[j * k->stride + 1] = k->data->y[k->reseeds[k->empty]];
+      k->empty++;
+      done = 0;
+    }
+    k->moved[j] = sqrt((k->centers[j * k->stride] - oldX) * (k->centers[j * k->stride] - oldX) + (k->centers[j * k->stride + 1] - oldY) * (k->centers[j * k->stride + 1] - oldY));
+    if (k->moved[j] > k->moved[k->farthest])
+      k->farthest = j;
+  }
+  k->secondMoved = 0.0;
+  for (j = 0; j < k->count; j++) {
+    if (j != k->farthest && k->moved[j] > k->secondMoved)
+      k->secondMoved = k->moved[j];
+  }
+  return done;
+}
+
+unsigned int kmeans(float *centers, int stride, int count, const Dataset *data, KMeansAlgorithm algorithm, Pool *pool) {
+  KMeans k;
+  double *sums = (double *)malloc(2 * count * sizeof(double));
+  unsigned int *assigned = (unsigned int *)malloc(count * sizeof(unsigned int));
+  unsigned int iterations = 0;
+  unsigned int i, block;
+  int j;
+  k.centers = centers;
+  k.stride = stride;
+  k.count = count;
+  k.data = data;
+  k.algorithm = algorithm;
+  k.pool = pool;
+  k.assignments = (int *)calloc(data->size, sizeof(int));
+  k.upper = NULL;
+  k.lower = NULL;
+  k.halfGap = (double *)malloc(count * sizeof(double));
+  k.moved = (double *)calloc(count, sizeof(double));
+  k.farthest = 0;
+  k.secondMoved = 0.0;
+  if (algorithm == KMEANS_HAMERLY) {
+    k.upper = (double *)malloc(data->size * sizeof(double));
+    k.lower = (double *)malloc(data->size * sizeof(double));
+    // force every input to be checked the first time through
+    for (i = 0; i < data->size; i++) {
+      k.upper[i] = HUGE_VAL;
+      k.lower[i] = 0.0;
+    }
+  }
+  splitBlocks(data->size, &k.blocks, &k.blockSize);
+  k.blockSums = (double *)malloc(k.blocks * 2 * count * sizeof(double));
+  k.blockAssigned = (unsigned int *)malloc(k.blocks * count * sizeof(unsigned int));
+  k.blockChanged = (char *)malloc(k.blocks);
+  k.blockFarthest = (unsigned int *)malloc(k.blocks * count * sizeof(unsigned int));
+  k.blockFarthestDistances = (double *)malloc(k.blocks * count * sizeof(double));
+  k.reseeds = (unsigned int *)malloc(count * sizeof(unsigned int));
+  k.reseedDistances = (double *)malloc(count * sizeof(double));
+
+  // organize into clusters
+  do {
+    if (algorithm == KMEANS_HAMERLY)
+      findGaps(&k);
+    runPool(pool, &assignBlocks, &k);
+    iterations++;
+  } while (!moveCenters(&k, sums, assigned));
+
+  // find variance
+  runPool(pool, &addVariances, &k);
+  memset(sums, 0, count * sizeof(double));
+  for (block = 0; block < k.blocks; block++) {
+    for (j = 0; j < count; j++) {
+      sums[j] += k.blockSums[2 * count * block + j];
+    }
+  }
+  for (j = 0; j < count; j++) {
+    centers[j * stride + 2] = (assigned[j] > 0 ? sums[j] / assigned[j] : 0.0) + 0.01;
+  }
+
+  // free memory
+  free(sums);
+  free(assigned);
+  free(k.assignments);
+  free(k.upper);
+  free(k.lower);
+  free(k.halfGap);
+  free(k.moved);
+  free(k.blockSums);
+  free(k.blockAssigned);
+  free(k.blockChanged);
+  free(k.blockFarthest);
+  free(k.blockFarthestDistances);
+  free(k.reseeds);
+  free(k.reseedDistances);
+  return iterations;
+}
+
+// rounds of k-means|| and how many candidates each round picks for every
+// center, on average
+#define PARALLEL_ROUNDS 5
+#define PARALLEL_OVERSAMPLING 2.0
+
+// everything the threads share while picking starting points
+typedef struct Seeding {
+  const Dataset *data;
+  Pool *pool;
+  unsigned int blocks;
+  unsigned int blockSize;
+  // the points picked so far as x, y pairs, the first of them that the
+  // distances don't include yet, and how many there are room for
+  float *candidates;
+  unsigned int candidateCount;
+  unsigned int first;
+  unsigned int capacity;
+  // the squared distance from every input to the closest candidate, which
+  // candidate that is, and the distances added up for each block
+  double *distances;
+  unsigned int *nearest;
+  double *blockSums;
+  // k-means|| picks every input with a chance of scale times its distance,
+  // with random numbers seeded by roundSeed and the block
+  double scale;
+  unsigned long long roundSeed;
+  // the inputs each block picked
+  unsigned int *picked;
+  unsigned int *blockPicked;
+} Seeding;
+
+static void addCandidate(Seeding *s, float x, float y) {
+  if (s->candidateCount == s->capacity) {
+    s->capacity *= 2;
+    s->candidates = (float *)realloc(s->candidates, 2 * s->capacity * sizeof(float));
+  }
+  s->candidates[2 * s->candidateCount] = x;
+  s->candidates[2 * s->candidateCount + 1] = y;
+  s->candidateCount++;
+}
+
+// bring the distances up to date with the new candidates
+static void updateDistances(unsigned int thread, void *arg) {
+  Seeding *s = (Seeding *)arg;
+  unsigned int block;
+  for (block = thread; block < s->blocks; block += s->pool->threads) {
+    unsigned int end = blockEnd(block, s->blockSize, s->data->size);
+    unsigned int i, c;
+    double sum = 0.0;
+    for (i = block * s->blockSize; i < end; i++) {
+      for (c = s->first; c < s->candidateCount; c++) {
+        double d = distance2(s->data, i, s->candidates + 2 * c);
+        if (d < s->distances[i]) {
+          s->distances[i] = d;
+          s->nearest[i] = c;
+        }
+      }
+      sum += s->distances[i];
+    }
+    s->blockSums[block] = sum;
+  }
+}
+
+// pick inputs for k-means|| in the thread's blocks
+static void sampleCandidates(unsigned int thread, void *arg) {
+  Seeding *s = (Seeding *)arg;
+  unsigned int block;
+  for (block = thread; block < s->blocks; block += s->pool->threads) {
+    unsigned int end = blockEnd(block, s->blockSize, s->data->size);
+    unsigned int *picked = s->picked + block * s->blockSize;
+    unsigned int i;
+    Rng rng;
+    seedRng(&rng, s->roundSeed + block, 0);
+    s->blockPicked[block] = 0;
+    for (i = block * s->blockSize; i < end; i++) {
+      if (randomUnit(&rng) < s->scale * s->distances[i])
+        picked[s->blockPicked[block]++] = i;
+    }
+  }
+}
+
+static double totalDistance(const Seeding *s) {
+  double total = 0.0;
+  unsigned int block;
+  for (block = 0; block < s->blocks; block++) {
+    total += s->blockSums[block];
+  }
+  return total;
+}
+
+// pick an input with a chance proportional to its distance from the
+// candidates, finding the block first from the block sums
+static unsigned int pickFar(const Seeding *s, Rng *rng) {
+  double total = totalDistance(s);
+  double r = randomUnit(rng) * total;
+  unsigned int block, i;
+  unsigned int last = 0;
+  // nothing left to pick from, everything sits right on a candidate
+  if (total <= 0.0)
+    return randomBelow(rng, s->data->size);
+  for (block = 0; block < s->blocks; block++) {
+    unsigned int end = blockEnd(block, s->blockSize, s->data->size);
+    if (r >= s->blockSums[block] && block + 1 < s->blocks) {
+      r -= s->blockSums[block];
+      continue;
+    }
+    for (i = block * s->blockSize; i < end; i++) {
+      if (s->distances[i] > 0.0) {
+        last = i;
+        r -= s->distances[i];
+        if (r < 0.0)
+          return i;
+      }
+    }
+    break;
+  }
+  // the sums rounded a little differently than the block sums
+  return last;
+}
+
+// k-means++ over the candidates, each counting as weights[c] inputs, for
+// k-means||
+static void narrowCandidates(float *centers, int stride, int count, const float *candidates, unsigned int candidateCount, const double *weights, Rng *rng) {
+  double *distances = (double *)malloc(candidateCount * sizeof(double));
+  unsigned int c, pick = 0;
+  int j;
+  for (c = 0; c < candidateCount; c++) {
+    distances[c] = 1.0;
+  }
+  for (j = 0; j < count; j++) {
+    double total = 0.0;
+    double r;
+    for (c = 0; c < candidateCount; c++) {
+      total += weights[c] * distances[c];
+    }
+    r = randomUnit(rng) * total;
+    for (c = 0; c < candidateCount; c++) {
+      if (weights[c] * distances[c] > 0.0) {
+        pick = c;
+        r -= weights[c] * distances[c];
+        if (r < 0.0)
+          break;
+      }
+    }
+    centers[j * stride] = candidates[2 * pick];
+    centers[j * stride + 1] = candidates[2 * pick + 1];
+    for (c = 0; c < candidateCount; c++) {
+      double dx = candidates[2 * c] - candidates[2 * pick];
+      double dy = candidates[2 * c + 1] - candidates[2 * pick + 1];
+      if (j == 0 || dx * dx + dy * dy < distances[c])
+        distances[c] = dx * dx + dy * dy;
+    }
+  }
+  free(distances);
+}
+
+void seedCenters(float *centers, int stride, int count, const Dataset *data, KMeansSeeding seeding, Rng *rng, Pool *pool) {
+  Seeding s;
+  unsigned int i, block;
+  int j;
+  if (seeding == KMEANS_SEED_RANDOM) {
+    // the start of a shuffle of the inputs
+    // with more centers than inputs another shuffle starts once they're all
+    // used, and the repeats are moved like empty clusters
+    unsigned int *order = (unsigned int *)malloc(data->size * sizeof(unsigned int));
+    for (i = 0; i < data->size; i++) {
+      order[i] = i;
+    }
+    for (j = 0; j < count; j++) {
+      unsigned int next = (unsigned int)j % data->size;
+      unsigned int offset = next + randomBelow(rng, data->size - next);
+      unsigned int index = order[next];
+      order[next] = order[offset];
+      order[offset] = index;
+      centers[j * stride] = data->x[order[next]];
+      centers[j * stride + 1] = data->y[order[next]];
+    }
+    free(order);
+    return;
+  }
+
+  s.data = data;
+  s.pool = pool;
+  splitBlocks(data->size, &s.blocks, &s.blockSize);
+  s.capacity = count;
+  s.candidates = (float *)malloc(2 * s.capacity * sizeof(float));
+  s.candidateCount = 0;
+  s.first = 0;
+  s.distances = (double *)malloc(data->size * sizeof(double));
+  s.nearest = (unsigned int *)malloc(data->size * sizeof(unsigned int));
+  s.blockSums = (double *)malloc(s.blocks * sizeof(double));
+  s.picked = NULL;
+  s.blockPicked = NULL;
+  for (i = 0; i < data->size; i++) {
+    s.distances[i] = HUGE_VAL;
+  }
+  // the first one is any input
+  i = randomBelow(rng, data->size);
+  addCandidate(&s, data->x[i], data->y[i]);
+  runPool(pool, &updateDistances, &s);
+
+  if (seeding == KMEANS_SEED_PARALLEL) {
+    // Bahmani et al., "Scalable k-means++", VLDB 2012
+    // each round picks every input with a chance proportional to its distance,
+    // about PARALLEL_OVERSAMPLING * count of them
+    int round;
+    s.picked = (unsigned int *)malloc(data->size * sizeof(unsigned int));
+    s.blockPicked = (unsigned int *)malloc(s.blocks * sizeof(unsigned int));
+    for (round = 0; round < PARALLEL_ROUNDS; round++) {
+      double total = totalDistance(&s);
+      if (total <= 0.0)
+        break;
+      s.scale = PARALLEL_OVERSAMPLING * count / total;
+      s.roundSeed = nextRandom(rng);
+      runPool(pool, &sampleCandidates, &s);
+      s.first = s.candidateCount;
+      for (block = 0; block < s.blocks; block++) {
+        for (i = 0; i < s.blockPicked[block]; i++) {
+          unsigned int input = s.picked[block * s.blockSize + i];
+          addCandidate(&s, data->x[input], data->y[input]);
+        }
+      }
+      runPool(pool, &updateDistances, &s);
+    }
+  }
+
+  if (s.candidateCount > (unsigned int)count) {
+    // every candidate counts as the inputs closest to it
+    double *weights = (double *)calloc(s.candidateCount, sizeof(double));
+    for (i = 0; i < data->size; i++) {
+      weights[s.nearest[i]] += 1.0;
+    }
+    narrowCandidates(centers, stride, count, s.candidates, s.candidateCount, weights, rng);
+    free(weights);
+  } else {
+    // k-means++, or the rest of the centers when k-means|| found too few
+    // Arthur and Vassilvitskii, "k-means++: the advantages of careful
+    // seeding", SODA 2007
+    while (s.candidateCount < (unsigned int)count) {
+      i = pickFar(&s, rng);
+      s.first = s.candidateCount;
+      addCandidate(&s, data->x[i], data->y[i]);
+      runPool(pool, &updateDistances, &s);
+    }
+    for (j = 0; j < count; j++) {
+      centers[j * stride] = s.candidates[2 * j];
+      centers[j * stride + 1] = s.candidates[2 * j + 1];
+    }
+  }
+
+  // free memory
+  free(s.candidates);
+  free(s.distances);
+  free(s.nearest);
+  free(s.blockSums);
+  free(s.picked);
+  free(s.blockPicked);
+}
+
+// inputs miniBatchKMeans reads from the stream at a time
+#define CHUNK_SIZE 65536
+// inputs miniBatchKMeans finds the variances from
+#define VARIANCE_SIZE 1048576
+
+// the closest center to an input of a chunk
+static int nearestCenter(const float *centers, int stride, int count, const Dataset *chunk, unsigned int i) {
+  int closest = 0;
+  double distance = distance2(chunk, i, centers);
+  int j;
+  for (j = 1; j < count; j++) {
+    double ndistance = distance2(chunk, i, centers + j * stride);
+    if (ndistance < distance) {
+      closest = j;
+      distance = ndistance;
+    }
+  }
+  return closest;
+}
+
+unsigned int miniBatchKMeans(float *centers, int stride, int count, DatasetStream *stream, unsigned int batchSize, unsigned int limit, double tolerance, Rng *rng) {
+  Dataset chunk;
+  // the order the current chunk is used in
+  unsigned int *order = (unsigned int *)malloc(CHUNK_SIZE * sizeof(unsigned int));
+  // the centers of the current mini-batch's inputs
+  int *assignments = (int *)malloc(batchSize * sizeof(int));
+  // the number of inputs each center has been moved toward
+  double *seen = (double *)calloc(count, sizeof(double));
+  // where the centers were when the current chunk was read
+  float *checkpoint = (float *)malloc(2 * count * sizeof(float));
+  double *sums = (double *)calloc(count, sizeof(double));
+  unsigned int *assigned = (unsigned int *)calloc(count, sizeof(unsigned int));
+  unsigned int batches = 0;
+  // the size of the current chunk and how much of it has been used
+  unsigned int size = 0;
+  unsigned int used = 0;
+  unsigned int samples = 0;
+  unsigned int i, end;
+  int j;
+  allocateDataset(&chunk, CHUNK_SIZE);
+  rewindDatasetStream(stream);
+
+  while (batches < limit) {
+    if (used == size) {
+      // stop once the centers hold still for a whole chunk
+      if (size > 0) {
+        double farthest = 0.0;
+        for (j = 0; j < count; j++) {
+          double dx = centers[j * stride] - checkpoint[2 * j];
+          double dy = centers[j * stride + 1] - checkpoint[2 * j + 1];
+          if (dx * dx + dy * dy > farthest)
+            farthest = dx * dx + dy * dy;
+        }
+        if (sqrt(farthest) <= tolerance)
+          break;
+      }
+      for (j = 0; j < count; j++) {
+        checkpoint[2 * j] = centers[j * stride];
+        checkpoint[2 * j + 1] = centers[j * stride + 1];
+      }
+      // next chunk, going back to the start when the stream runs out
+      size = readDatasetChunk(stream, &chunk, CHUNK_SIZE);
+      if (size == 0) {
+        rewindDatasetStream(stream);
+        size = readDatasetChunk(stream, &chunk, CHUNK_SIZE);
+        if (size == 0)
+          break;
+      }
+      // mini-batches are taken from the chunk in a random order
+      for (i = 0; i < size; i++) {
+        order[i] = i;
+      }
+      for (i = 0; i + 1 < size; i++) {
+        unsigned int offset = i + randomBelow(rng, size - i);
+        unsigned int index = order[i];
+        order[i] = order[offset];
+        order[offset] = index;
+      }
+      used = 0;
+    }
+    end = used + batchSize > size ? size : used + batchSize;
+    // assign the whole mini-batch before any center moves
+    for (i = used; i < end; i++) {
+      assignments[i - used] = nearestCenter(centers, stride, count, &chunk, order[i]);
+    }
+    // then move each center a little less every time
+    for (i = used; i < end; i++) {
+      float *center = centers + assignments[i - used] * stride;
+      double rate = 1.0 / ++seen[assignments[i - used]];
+      center[0] += rate * (chunk.x[order[i]] - center[0]);
+      center[1] += rate * (chunk.y[order[i]] - center[1]);
+    }
+    used = end;
+    batches++;
+  }
+
+  // find variance from the start of the stream
+  rewindDatasetStream(stream);
+  while (samples < VARIANCE_SIZE && (size = readDatasetChunk(stream, &chunk, CHUNK_SIZE < VARIANCE_SIZE - samples ? CHUNK_SIZE : VARIANCE_SIZE - samples)) > 0) {
+    for (i = 0; i < size; i++) {
+      j = nearestCenter(centers, stride, count, &chunk, i);
+      sums[j] += distance2(&chunk, i, centers + j * stride);
+      assigned[j]++;
+    }
+    samples += size;
+  }
+  for (j = 0; j < count; j++) {
+    // a center nothing is close to just gets the minimum
+    centers[j * stride + 2] = (assigned[j] > 0 ? sums[j] / assigned[j] : 0.0) + 0.01;
+  }
+
+  // free memory
+  freeDataset(&chunk);
+  free(order);
+  free(assignments);
+  free(seen);
+  free(checkpoint);
+  free(sums);
+  free(assigned);
+  return batches;
+}
@@ -0,0 +1,70 @@
+#ifndef KMEANS_H
+#define KMEANS_H
+
+#include "dataset.h"
+#include "threads.h"
+#include "rng.h"
+
+// the ways the centers can be found
+// lloyd and hamerly find the same centers from the same starting points,
+// hamerly just skips most of the distances lloyd computes
+// minibatch is miniBatchKMeans, which only gets close to them but never needs
+// the whole training set at once
+typedef enum KMeansAlgorithm {
+  KMEANS_LLOYD,
+  KMEANS_HAMERLY,
+  KMEANS_MINIBATCH
+} KMeansAlgorithm;
+
+// the ways the starting centers can be picked
+// random picks different inputs. plusplus is k-means++, which picks each one
+// with a chance proportional to its squared distance from the ones already
+// picked, so they start spread out and fewer iterations are needed. parallel
+// is k-means||, which picks a few times as many candidates in only a few
+// passes over the inputs and then narrows them down with k-means++
+typedef enum KMeansSeeding {
+  KMEANS_SEED_RANDOM,
+  KMEANS_SEED_PLUSPLUS,
+  KMEANS_SEED_PARALLEL
+} KMeansSeeding;
+
+// inputs per mini-batch, mini-batches before miniBatchKMeans gives up, and how
+// far the centers can still be moving when it stops
+#define MINIBATCH_SIZE 1024
+#define MINIBATCH_LIMIT 4096
+#define MINIBATCH_TOLERANCE 0.001
+
+// move count centers that already hold starting points to the means of the
+// inputs closest to them until no input changes centers, then set each
+// center's variance to the variance of its inputs plus 0.01
+// a center no input is closest to is moved onto the input furthest from its
+// own center
+// the centers are laid out like the rbf weights: meanx, meany, var, and the
+// next center stride floats later
+// the inputs are split into blocks that are dealt out to the pool's threads
+// and added up in order, so the centers come out the same for any number of
+// threads
+// algorithm is lloyd or hamerly
+// returns the number of iterations it took
+unsigned int kmeans(float *centers, int stride, int count, const Dataset *data, KMeansAlgorithm algorithm, Pool *pool);
+
+// put starting points into count centers laid out like kmeans wants them,
+// using the seeding
+// the passes over the inputs are split between the pool's threads in the same
+// blocks as kmeans, so the starting points only depend on rng
+// the variances are left alone
+void seedCenters(float *centers, int stride, int count, const Dataset *data, KMeansSeeding seeding, Rng *rng, Pool *pool);
+
+// Sculley, "Web-scale k-means clustering", WWW 2010
+// move count centers that already hold starting points toward random
+// mini-batches of batchSize inputs read from the stream a chunk at a time,
+// each center with a learning rate of one over the number of inputs it has
+// seen so far. It stops after limit mini-batches or when no center moved
+// further than tolerance over a whole chunk, then sets each center's variance
+// like kmeans does from the first chunks of the stream
+// the stream is rewound whenever it runs out, and the chunks are shuffled
+// with rng, but a file sorted by position should be shuffled first
+// returns the number of mini-batches it took
+unsigned int miniBatchKMeans(float *centers, int stride, int count, DatasetStream *stream, unsigned int batchSize, unsigned int limit, double tolerance, Rng *rng);
+
+#endif
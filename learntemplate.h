@@ -0,0 +1,231 @@
+// the parts of learning that call the activation function
+// nn.c includes this once per activation function and accuracy after defining:
+// SPECIALIZED(name)   the name of a function for this activation function
+// ACCURACY            the Accuracy of exp in the rbf layer
+// ACTIVATE(x)         the activation function
+// DERIVE(y)           its derivative, given the activation y instead of x
+// so each one gets its own copy with the function inlined instead of a call
+// through a pointer for every node, and it undefines them when it's done
+
+// present one input and update the weights right away
+// returns the contribution of this input to the mse
+static double SPECIALIZED(learnSample)(NNScratch *scratch, const InputOrder *inputs, unsigned int position) {
+  unsigned int index = INPUT_INDEX(inputs, position);
+  int j, k;
+  unsigned int startLayer;
+  GLfloat *myWeights;
+  NNFloat *myMomentums;
+  double mse;
+  PROFILE_SAMPLE(scratch);
+  // clear errors
+  bzero(scratch->errors, nnData.errorsSize * sizeof(NNFloat));
+  PROFILE_ADD(scratch, PHASE_CLEAR);
+  // input values
+  scratch->values[1] = inputs->data->x[index];
+  scratch->values[2] = inputs->data->y[index];
+
+  startLayer = 1;
+  if (nnData.isRBF) {
+    startLayer++;
+    rbfLayer(scratch->layerValues[1], inputs, position, scratch->values[1], scratch->values[2], ACCURACY);
+    PROFILE_ADD_LAYER(scratch, PHASE_FORWARD, 1);
+  }
+
+  // find outputs - forward
+  // myWeights points to the weights for the current set of inputs and output
+  myWeights = nnData.layerWeights[startLayer - 1];
+  for (j = startLayer; j < nnData.layers; j++) {
+    for (k = 0; k < nnData.layerSizes[j]; k++) {
+      // activate!
+      scratch->layerValues[j][k + 1] = ACTIVATE(kernels.dot(myWeights, scratch->layerValues[j - 1], nnData.layerSizes[j - 1] + 1));
+      // advance myWeights to the next node
+      myWeights += nnData.layerSizes[j - 1] + 1;
+    }
+    PROFILE_ADD_LAYER(scratch, PHASE_FORWARD, j);
+  }
+
+  // find the errors - backward
+  scratch->errors[nnData.errorsSize - 1] = inputs->data->target[index] - scratch->values[nnData.valuesSize - 1];
+  mse = 0.25 * pow(scratch->errors[nnData.errorsSize - 1], 2);
+  PROFILE_ADD(scratch, PHASE_MSE);
+  for (j = nnData.layers - 2; j >= startLayer; j--) {
+    // myWeights here goes something like 6 7 3 4 5 1 2
+    // jump backwards here
+    myWeights = nnData.layerWeights[j];
+    for (k = 0; k < nnData.layerSizes[j + 1]; k++) {
+      // sum up errors
+      kernels.backpropagate(scratch->layerErrors[j], myWeights + 1, scratch->layerErrors[j + 1][k], nnData.layerSizes[j]);
+      // advance myWeights
+      myWeights += nnData.layerSizes[j] + 1;
+    }
+    PROFILE_ADD_LAYER(scratch, PHASE_BACKWARD, j);
+  }
+
+  // learn - forward
+  // myMomentums and myWeights are the same idea
+  myWeights = nnData.layerWeights[startLayer - 1];
+  myMomentums = nnData.layerMomentums[startLayer - 1];
+  for (j = startLayer; j < nnData.layers; j++) {
+    for (k = 0; k < nnData.layerSizes[j]; k++) {
+      NNFloat delta = DERIVE(scratch->layerValues[j][k + 1]) * scratch->layerErrors[j][k] * nnData.learnRate;
+      // calculate the change into the momentum term and update the weights
+      kernels.update(myWeights, myMomentums, scratch->layerValues[j - 1], delta, nnData.momentum, nnData.layerSizes[j - 1] + 1);
+      // advance pointers
+      myWeights += nnData.layerSizes[j - 1] + 1;
+      myMomentums += nnData.layerSizes[j - 1] + 1;
+    }
+    PROFILE_ADD_LAYER(scratch, PHASE_UPDATE, j);
+  }
+#if 0
+  // print tons of information
+  // will slow things down a lot
+  printf("values:\n");
+  for (j = 0; j < nnData.valuesSize; j++) {
+    printf("%f\n", scratch->values[j]);
+  }
+  printf("errors:\n");
+  for (j = 0; j < nnData.errorsSize; j++) {
+    printf("%f\n", scratch->errors[j]);
+  }
+  printf("momentums:\n");
+  for (j = 0; j < nnData.weightsSize; j++) {
+    printf("%f\n", nnData.momentums[j]);
+  }
+  printf("weights:\n");
+  for (j = 0; j < nnData.weightsSize; j++) {
+    printf("%f\n", nnData.weights[j]);
+  }
+#endif
+  // add error to total
+  return mse;
+}
+
+// find the output for a point without learning anything
+static NNFloat SPECIALIZED(evaluate)(NNScratch *scratch, NNFloat x, NNFloat y) {
+  int j, k;
+  unsigned int startLayer = 1;
+  GLfloat *myWeights;
+  scratch->values[1] = x;
+  scratch->values[2] = y;
+  if (nnData.isRBF) {
+    startLayer++;
+    evaluateRBF(scratch->layerValues[1], x, y, ACCURACY);
+  }
+  myWeights = nnData.layerWeights[startLayer - 1];
+  for (j = startLayer; j < nnData.layers; j++) {
+    for (k = 0; k < nnData.layerSizes[j]; k++) {
+      scratch->layerValues[j][k + 1] = ACTIVATE(kernels.dot(myWeights, scratch->layerValues[j - 1], nnData.layerSizes[j - 1] + 1));
+      myWeights += nnData.layerSizes[j - 1] + 1;
+    }
+  }
+  return scratch->values[nnData.valuesSize - 1];
+}
+
+// find outputs for a whole batch - forward
+// this is the product of the batch's values and the layer's weights,
+// done a block of nodes at a time so the block's weights stay in cache while
+// every sample of the batch goes through them
+// the sums go straight into the values and are activated in place
+static void SPECIALIZED(forwardBatch)(NNScratch *scratch, unsigned int startLayer, int count) {
+  int j, k, s, k0, s0;
+  for (j = startLayer; j < nnData.layers; j++) {
+    int inputs = nnData.layerSizes[j - 1] + 1;
+    for (k0 = 0; k0 < nnData.layerSizes[j]; k0 += BLOCK_NODES) {
+      int kEnd = MIN(k0 + BLOCK_NODES, nnData.layerSizes[j]);
+      for (s0 = 0; s0 < count; s0 += BLOCK_SAMPLES) {
+        int sEnd = MIN(s0 + BLOCK_SAMPLES, count);
+        for (k = k0; k < kEnd; k++) {
+          GLfloat *myWeights = nnData.layerWeights[j - 1] + k * inputs;
+          // four samples at a time share each weight load and keep four
+          // independent sums going
+          for (s = s0; s + 4 <= sEnd; s += 4) {
+            NNFloat sums[4];
+            kernels.dot4(myWeights, batchLayerValues(scratch, s, j - 1), batchLayerValues(scratch, s + 1, j - 1), batchLayerValues(scratch, s + 2, j - 1), batchLayerValues(scratch, s + 3, j - 1), inputs, sums);
+            batchLayerValues(scratch, s, j)[k + 1] = sums[0];
+            batchLayerValues(scratch, s + 1, j)[k + 1] = sums[1];
+            batchLayerValues(scratch, s + 2, j)[k + 1] = sums[2];
+            batchLayerValues(scratch, s + 3, j)[k + 1] = sums[3];
+          }
+          for (; s < sEnd; s++) {
+            batchLayerValues(scratch, s, j)[k + 1] = kernels.dot(myWeights, batchLayerValues(scratch, s, j - 1), inputs);
+          }
+        }
+      }
+    }
+    // activate!
+    for (s = 0; s < count; s++) {
+      NNFloat *myValues = batchLayerValues(scratch, s, j);
+      for (k = 0; k < nnData.layerSizes[j]; k++) {
+        myValues[k + 1] = ACTIVATE(myValues[k + 1]);
+      }
+    }
+    PROFILE_ADD_LAYER(scratch, PHASE_FORWARD, j);
+  }
+}
+
+// sum up the weight changes asked for by every sample of the batch
+// this is the product of the transposed deltas and the batch's values
+static void SPECIALIZED(accumulateGradients)(NNScratch *scratch, unsigned int startLayer, int count, NNFloat *gradients) {
+  int j, k, s, k0, s0;
+  for (j = startLayer; j < nnData.layers; j++) {
+    int inputs = nnData.layerSizes[j - 1] + 1;
+    NNFloat *layerGradients = gradients + (nnData.layerWeights[j - 1] - nnData.weights);
+    bzero(layerGradients, nnData.layerSizes[j] * inputs * sizeof(NNFloat));
+    for (k0 = 0; k0 < nnData.layerSizes[j]; k0 += BLOCK_NODES) {
+      int kEnd = MIN(k0 + BLOCK_NODES, nnData.layerSizes[j]);
+      for (s0 = 0; s0 < count; s0 += BLOCK_SAMPLES) {
+        int sEnd = MIN(s0 + BLOCK_SAMPLES, count);
+        for (k = k0; k < kEnd; k++) {
+          NNFloat *myGradients = layerGradients + k * inputs;
+          for (s = s0; s < sEnd; s++) {
+            NNFloat delta = DERIVE(batchLayerValues(scratch, s, j)[k + 1]) * batchLayerErrors(scratch, s, j)[k] * nnData.learnRate;
+            kernels.accumulate(myGradients, batchLayerValues(scratch, s, j - 1), delta, inputs);
+          }
+        }
+      }
+    }
+    PROFILE_ADD_LAYER(scratch, PHASE_UPDATE, j);
+  }
+}
+
+// present a batch of inputs and sum up the changes they ask for in gradients
+// returns the contribution of the batch to the mse
+static double SPECIALIZED(batchGradients)(NNScratch *scratch, const InputOrder *inputs, unsigned int first, int count, NNFloat *gradients) {
+  int s;
+  unsigned int startLayer = nnData.isRBF ? 2 : 1;
+  double mse = 0.0;
+  PROFILE_SAMPLE(scratch);
+  // clear errors
+  bzero(scratch->batchErrors, count * nnData.errorsSize * sizeof(NNFloat));
+  PROFILE_ADD(scratch, PHASE_CLEAR);
+  for (s = 0; s < count; s++) {
+    unsigned int index = INPUT_INDEX(inputs, first + s);
+    NNFloat *myValues = batchLayerValues(scratch, s, 0);
+    // input values
+    myValues[1] = inputs->data->x[index];
+    myValues[2] = inputs->data->y[index];
+    if (nnData.isRBF) {
+      rbfLayer(batchLayerValues(scratch, s, 1), inputs, first + s, myValues[1], myValues[2], ACCURACY);
+    }
+  }
+  if (nnData.isRBF) {
+    PROFILE_ADD_LAYER(scratch, PHASE_FORWARD, 1);
+  }
+
+  SPECIALIZED(forwardBatch)(scratch, startLayer, count);
+  for (s = 0; s < count; s++) {
+    NNFloat *myErrors = scratch->batchErrors + s * nnData.errorsSize;
+    myErrors[nnData.errorsSize - 1] = inputs->data->target[INPUT_INDEX(inputs, first + s)] - scratch->batchValues[s * nnData.valuesSize + nnData.valuesSize - 1];
+    // add error to total
+    mse += 0.25 * pow(myErrors[nnData.errorsSize - 1], 2);
+  }
+  PROFILE_ADD(scratch, PHASE_MSE);
+  backwardBatch(scratch, startLayer, count);
+  SPECIALIZED(accumulateGradients)(scratch, startLayer, count, gradients);
+  return mse;
+}
+
+#undef SPECIALIZED
+#undef ACCURACY
+#undef ACTIVATE
+#undef DERIVE
@@ -100,7 +100,7 @@ static void display() {
   glVertexAttribPointer(glData.pointsPositionAttribute, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLfloat*)0);
   glEnableVertexAttribArray(glData.pointsColorAttribute);
   glVertexAttribPointer(glData.pointsColorAttribute, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLfloat*)0 + 2);
-  glDrawArrays(GL_QUADS, 0, nnData.inputsSize * 4);
+  glDrawArrays(GL_QUADS, 0, nnData.inputs.size * 4);
 
   glutSwapBuffers();
 }
@@ -132,6 +132,7 @@ static void idle() {
   // if we aren't in turbo mode, learn once per redraw
   double mse = learn();
   printf("%d\t%f\n", nnData.epoch, mse);
+  reportProfile();
 #endif
   glUseProgram(glData.quadProgram);
   glUniform1fv(glData.weightsUniform, nnData.weightsSize, nnData.weights);
@@ -141,6 +142,7 @@ static void idle() {
 #ifdef TURBO
 // in turbo mode we learn as fast as possible
 // this is not thread safe, but the display just gets a little weird at worst
+// with -t this thread is joined by more for each epoch
 #ifndef __WIN32__
 static void *learnStuff(void *v) {
 #else
@@ -149,6 +151,7 @@ static DWORD WINAPI learnStuff(LPVOID *v) {
   while(1) {
     double mse = learn();
     printf("%d\t%f\n", nnData.epoch, mse);
+    reportProfile();
   }
 #ifndef __WIN32__
   return NULL;
@@ -285,25 +288,26 @@ int main(int argc, char **argv) {
     glData.pointsColorAttribute = glGetAttribLocation(glData.pointsProgram, "color");
 
     // build point VBO
-    pointsArraySize = nnData.inputsSize * 4 * (2 + 3) * sizeof(GLfloat);
+    pointsArraySize = nnData.inputs.size * 4 * (2 + 3) * sizeof(GLfloat);
     pointsArray = (GLfloat *)malloc(pointsArraySize);
-    for (i = 0; i < nnData.inputsSize; i++) {
-      InputVector *iv = nnData.inputs + i;
+    for (i = 0; i < nnData.inputs.size; i++) {
+      float x = nnData.inputs.x[i];
+      float y = nnData.inputs.y[i];
       GLfloat *point = pointsArray + i * 4 * (2 + 3);
       GLfloat color[3] = {0.0, 0.0, 0.0};
-      if (iv->target == 1)
+      if (nnData.inputs.target[i] == 1)
         color[2] = 1.0;
-      point[0] = iv->x / 10.0 - PWIDTH;
-      point[1] = iv->y / 10.0 - PWIDTH;
+      point[0] = x / 10.0 - PWIDTH;
+      point[1] = y / 10.0 - PWIDTH;
       memcpy(point + 2, color, sizeof(color));
-      point[5] = iv->x / 10.0 + PWIDTH;
-      point[6] = iv->y / 10.0 - PWIDTH;
+      point[5] = x / 10.0 + PWIDTH;
+      point[6] = y / 10.0 - PWIDTH;
       memcpy(point + 7, color, sizeof(color));
-      point[10] = iv->x / 10.0 + PWIDTH;
-      point[11] = iv->y / 10.0 + PWIDTH;
+      point[10] = x / 10.0 + PWIDTH;
+      point[11] = y / 10.0 + PWIDTH;
       memcpy(point + 12, color, sizeof(color));
-      point[15] = iv->x / 10.0 - PWIDTH;
-      point[16] = iv->y / 10.0 + PWIDTH;
+      point[15] = x / 10.0 - PWIDTH;
+      point[16] = y / 10.0 + PWIDTH;
       memcpy(point + 17, color, sizeof(color));
     }
     glGenBuffers(1, &glData.pointsVbo);
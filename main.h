@@ -1,3 +1,8 @@
+#ifdef HEADLESS
+// training doesn't draw anything, it only needs the types
+typedef float GLfloat;
+typedef unsigned int GLuint;
+#else
 #ifdef __APPLE__
 #include <OpenGL/gl.h>
 #else
@@ -7,11 +12,28 @@
 #endif
 #include <GL/gl.h>
 #endif
+#endif
+
+#include "dataset.h"
+#include "rng.h"
+#include "rbfgrid.h"
+#include "kmeans.h"
+#include "profile.h"
 
 #ifdef __WIN32__
 #define bzero(a, b) memset((a), 0, (b))
 #endif
 
+// the type the network computes with
+// SINGLE_PRECISION uses floats everywhere, which fits twice as many numbers in
+// a vector register and in the cache, but sums that need the precision(like
+// the mse over an epoch) are still doubles
+#ifdef SINGLE_PRECISION
+typedef float NNFloat;
+#else
+typedef double NNFloat;
+#endif
+
 typedef enum ActivationFunction {
   ACTIVATION_HYPERBOLIC_TANGENT,
   ACTIVATION_LOGISTIC,
@@ -19,6 +41,13 @@ typedef enum ActivationFunction {
   ACTIVATION_LINEAR
 } ActivationFunction;
 
+// how closely exp and the activation functions follow libm, see fastmath.h
+typedef enum Accuracy {
+  ACCURACY_EXACT,
+  ACCURACY_FAST,
+  ACCURACY_FASTER
+} Accuracy;
+
 typedef struct GLData {
   GLuint quadVbo;
   GLuint ubo;
@@ -38,11 +67,55 @@ typedef struct GLData {
   GLuint weightsUniform;
 } GLData;
 
-typedef struct InputVector {
-  float x;
-  float y;
-  int target;
-} InputVector;
+// everything a thread writes to while it presents inputs to the network
+// each training thread gets its own, so the weights and momentums are the
+// only things they share
+typedef struct NNScratch {
+  // all values arranged as follows
+  // layer 0:
+  // bias, x, y
+  // layer 1:
+  // bias, layer1-0, layer1-1
+  // layer 2:
+  // bias, layer2-0
+  NNFloat *values;
+  // all errors arranged as follows
+  // layer 0: (no errors because these values are not computed)
+  // layer 1:
+  // layer1-0, layer1-1
+  // layer 2:
+  // layer2-0
+  // layer 1 is left out in an rbf
+  NNFloat *errors;
+
+  // just pointers to the layer offsets in the corresponding arrays
+  NNFloat **layerValues;
+  NNFloat **layerErrors;
+
+  // values and errors for every input in a batch
+  // each input gets a copy of the layout of the single input arrays above
+  NNFloat *batchValues;
+  NNFloat *batchErrors;
+  // changes to the weights summed over a batch, arranged like the weights
+  NNFloat *gradients;
+
+  // the error this thread saw during the current epoch
+  double mse;
+
+#ifdef PROFILE
+  // when the current phase started, or 0 if it isn't being timed
+  unsigned long long profileMark;
+  // how many times the ticks being timed count, see PROFILE_INTERVAL
+  unsigned int profileWeight;
+  // the number of inputs or batches started, to pick the ones to time
+  unsigned int profileCalls;
+  // the ticks spent in each phase since the last report
+  unsigned long long phaseTime[PHASE_COUNT];
+  // and in each layer for the phases before PHASE_LAYERED, a row of
+  // nnData.layers for each
+  unsigned long long *layerTime;
+#endif
+} NNScratch;
 
 typedef struct NNData {
   // number of weights
@@ -60,34 +133,8 @@ typedef struct NNData {
   GLfloat *weights;
   // number of values(one for every node, and a bias for every layer)
   unsigned int valuesSize;
-  // number of preactivation values(one for every node)
-  unsigned int preActivatesSize;
-  // all values arranged as follows
-  // layer 0:
-  // bias, x, y
-  // layer 1:
-  // bias, layer1-0, layer1-1
-  // layer 2:
-  // bias, layer2-0
-  double *values;
-  // all preactivates arranged as follows
-  // layer 0: (no preactivations because these values are not computed)
-  // layer 1:
-  // layer1-0, layer1-1
-  // layer 2:
-  // layer2-0
-  // layer 1 is left out in an rbf
-  double *preActivates;
   // number of errors
   unsigned int errorsSize;
-  // all errors arranged as follows
-  // layer 0: (no errors because these values are not computed)
-  // layer 1:
-  // layer1-0, layer1-1
-  // layer 2:
-  // layer2-0
-  // layer 1 is left out in an rbf
-  double *errors;
   // all momentums arranged as follows
   // layer 0: (no weights because it's the input layer)
   // layer 1: (if it has two nodes)
@@ -96,7 +143,7 @@ typedef struct NNData {
   // layer 2: (if it has one node)
   // bias, layer1-0, layer1-1
   // layer 1 is unused in an rbf
-  double *momentums;
+  NNFloat *momentums;
   // number of layers
   unsigned int layers;
   // size of each layer
@@ -104,17 +151,56 @@ typedef struct NNData {
 
   // just pointers to the layer offsets in the corresponding arrays
   GLfloat **layerWeights;
-  double **layerPreActivates;
-  double **layerValues;
-  double **layerErrors;
-  double **layerMomentums;
+  NNFloat **layerMomentums;
+
+  // number of inputs presented before the weights are updated
+  // 1 updates after every input
+  unsigned int batchSize;
+
+  // number of threads training at once
+  // they all update the same weights without any locking
+  unsigned int threads;
+  // one for each thread
+  NNScratch *scratch;
+
+  // with deterministic set the threads share every batch instead of every
+  // epoch, which gives the same results for any number of threads
+  unsigned char deterministic;
+  // the gradients and errors for each shard of a batch
+  NNFloat *shardGradients;
+  double *shardMSE;
+
+  // everything random comes from this seed
+  unsigned long long seed;
+  // random numbers for shuffling and picking the starting weights
+  // the training threads don't draw any, so they all share this one
+  Rng rng;
 
-  // number of input vectors
-  unsigned int inputsSize;
   // all input vectors
-  InputVector *inputs;
-  // a randomized list of input vectors
-  InputVector **shuffledInputs;
+  Dataset inputs;
+  // the indices of the inputs in the order they're presented this epoch
+  unsigned int *order;
+  // with shuffleCopy set the inputs are also copied into shuffledInputs in
+  // that order every epoch, so training reads them sequentially instead of
+  // jumping around the columns
+  unsigned char shuffleCopy;
+  Dataset shuffledInputs;
+
+  // with streamBlock set the training set stays on disk, and every epoch reads
+  // it streamBlock inputs at a time in a random order of blocks, each one while
+  // the one before it trains
+  // inputs then only holds the first block, for the preview and the rbf centers
+  unsigned int streamBlock;
+  DatasetStream stream;
+  // the blocks in the order they're trained this epoch
+  unsigned int *streamBlocks;
+  unsigned int streamBlockCount;
+  // one block trains while the other is read, streamCurrent is the one that's
+  // ready to train
+  Dataset streamBuffers[2];
+  unsigned int streamCurrent;
+  // the order the inputs of a block are trained in
+  unsigned int *streamOrder;
 
   // factors
   double learnRate;
@@ -123,15 +209,43 @@ typedef struct NNData {
 
   // used to select the activation function for the shader
   ActivationFunction function;
-
-  // pointers to the functions called by the C code
-  double (*activate)(double);
-  double (*derive)(double);
+  // used to select the exp the C code computes it with
+  Accuracy accuracy;
 
   // the number of times learn has been called
   unsigned int epoch;
 
+#ifdef PROFILE
+  // reportProfile prints every this many epochs, or never if 0
+  unsigned int profileEpochs;
+  // the ticks spent in learn and the inputs it presented since the last report
+  unsigned long long profileLearn;
+  unsigned long long profileInputs;
+#endif
+
   unsigned char isRBF;
+  // the rbf layer's values for every input, one row of layerSizes[1] + 1 with
+  // the bias first for each input in nnData.inputs, or NULL if they didn't fit
+  NNFloat *rbfCache;
+  // with a cutoff the rbf values are kept sparse instead: input i's nonzero
+  // values are rbfSparseValues[rbfSparseStart[i]] up to
+  // rbfSparseValues[rbfSparseStart[i + 1]], for the centers in
+  // rbfSparseCenters at the same places
+  unsigned long long *rbfSparseStart;
+  unsigned int *rbfSparseCenters;
+  NNFloat *rbfSparseValues;
+  // the most megabytes the rbf cache may take up
+  unsigned int rbfCacheLimit;
+  // centers further than this many standard deviations from an input are
+  // treated as 0 for it, 0 to always use every center
+  double rbfCutoff;
+  // finds the centers within the cutoff, when there is one
+  RBFGrid rbfGrid;
+  // how cluster() finds the rbf centers and where it starts them
+  KMeansAlgorithm kmeansAlgorithm;
+  KMeansSeeding kmeansSeeding;
+  // whether cluster() saves the centers it finds and loads them next time
+  unsigned char cacheCenters;
 } NNData;
 
 extern GLData glData;
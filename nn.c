@@ -23,238 +23,563 @@
 
 #include "nn.h"
 #include "main.h"
+#include "kernels.h"
+#include "threads.h"
+#include "fastmath.h"
+#include "kmeans.h"
+#include "centercache.h"
 
-#ifdef __WIN32__
-#define random() rand()
+#ifdef _MSC_VER
+#define strtoull _strtoui64
 #endif
 
-typedef struct Input Input;
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
 
-struct Input {
-  InputVector input;
-  Input *next;
-};
+#ifdef SINGLE_PRECISION
+#define EXP expf
+#define POW powf
+#else
+#define EXP exp
+#define POW pow
+#endif
 
-static void addInput(double x, double y, int target, Input ***eoInputs) {
-  Input *input = (Input *)malloc(sizeof(Input));
-  input->input.x = x;
-  input->input.y = y;
-  input->input.target = 2 * target - 1;
-  input->next = NULL;
-  **eoInputs = input;
-  *eoInputs = &input->next;
-}
+// mini-batches are multiplied through the layers in blocks of this many
+// samples by this many nodes, small enough that a block of weights and a
+// block of values fit in the cache together
+#define BLOCK_SAMPLES 16
+#define BLOCK_NODES 32
+
+// with -d batches are split into shards of this many inputs
+// it can't depend on the number of threads or the sums would too
+#define SHARD_SIZE 16
+// and the shards' gradients are added up this many weights at a time
+#define REDUCE_CHUNK 1024
+
+// the stream of the seed that places the rbf centers
+#define CLUSTER_STREAM 1
+
+// the threads used to train
+static Pool pool;
+#ifndef SLOW
+// a thread to train and a thread to read the next block with -O
+static Pool streamPool;
+#endif
 
 static void shuffle() {
-  int i;
-  for (i = 0; i < nnData.inputsSize - 1; i++) {
+  unsigned int i;
+  PROFILE_MARK(nnData.scratch);
+  for (i = 0; i + 1 < nnData.inputs.size; i++) {
     // pick a number between i and the end of the list
-    int offset = i + random() % (nnData.inputsSize - i);
+    unsigned int offset = i + randomBelow(&nnData.rng, nnData.inputs.size - i);
     // swap the current index and the random one
-    InputVector *iv = nnData.shuffledInputs[i];
-    nnData.shuffledInputs[i] = nnData.shuffledInputs[offset];
-    nnData.shuffledInputs[offset] = iv;
-  }
-}
-
-static void readTrainingSet(char *file) {
-  // open file
-  FILE *f = fopen(file, "r");
-  double x;
-  double y;
-  int target;
-  Input *inputs;
-  Input **eoInputs = &inputs;
-  InputVector *output;
-  int count = 0;
-  int i;
-  // read inputs into linked list
-  while (fscanf(f, "%lf\t%lf\t%d\n", &x, &y, &target) == 3) {
-    addInput(x, y, target, &eoInputs);
-    count++;
-  }
-  fclose(f);
-  // turn linked list into array
-  nnData.inputs = malloc(sizeof(InputVector) * count);
-  nnData.inputsSize = count;
-  output = nnData.inputs;
-  while (inputs != NULL) {
-    Input *next;
-    memcpy(output, inputs, sizeof(InputVector));
-    output++;
-    next = inputs->next;
-    free(inputs);
-    inputs = next;
-  }
-  // copy the list into the shuffled list
-  // this is in order but will be shuffled on the first learn
-  nnData.shuffledInputs = malloc(sizeof(InputVector *) * count);
-  for (i = 0; i < count; i++) {
-    nnData.shuffledInputs[i] = nnData.inputs + i;
+    unsigned int index = nnData.order[i];
+    nnData.order[i] = nnData.order[offset];
+    nnData.order[offset] = index;
+  }
+  if (nnData.shuffleCopy)
+    gatherDataset(&nnData.shuffledInputs, &nnData.inputs, nnData.order);
+  PROFILE_ADD(nnData.scratch, PHASE_SHUFFLE);
+}
+
+// exp from libm or fastmath.h
+// the accuracy is always a constant, so this turns into one of them
+static INLINE double tieredExp(double x, Accuracy accuracy) {
+  switch (accuracy) {
+    case ACCURACY_FAST:
+      return fastExp(x);
+    case ACCURACY_FASTER:
+      return fasterExp(x);
+    default:
+      return exp(x);
   }
 }
 
-static double activate_htan(double x) {
-  double powe;
+static INLINE NNFloat activate_htan(NNFloat x, Accuracy accuracy) {
+  NNFloat powe;
+  switch (accuracy) {
+    case ACCURACY_FAST:
+      return fastTanh(x);
+    case ACCURACY_FASTER:
+      return fasterTanh(x);
+    default:
+      break;
+  }
   // 42: the answer to life, the universe, and when to stop raising e to 2 * x
   if (x > 42.0)
     return 1.0;
   if (x < -42.0)
     return -1.0;
-  powe = exp(2.0 * x);
+  powe = EXP(2.0 * x);
   return (powe - 1.0) / (powe + 1.0);
 }
 
-static double activate_log(double x) {
+static INLINE NNFloat activate_log(NNFloat x, Accuracy accuracy) {
+  switch (accuracy) {
+    case ACCURACY_FAST:
+      return 2.0 * fastLogistic(x) - 1.0;
+    case ACCURACY_FASTER:
+      return 2.0 * fasterLogistic(x) - 1.0;
+    default:
+      break;
+  }
   if (x > 84.0)
     return 1.0;
   if (x < -84.0)
     return -1.0;
-  return 2.0 / (1.0 + exp(-x)) - 1.0;
+  return 2.0 / (1.0 + EXP(-x)) - 1.0;
 }
 
-static double activate_step(double x) {
+static INLINE NNFloat activate_step(NNFloat x, Accuracy accuracy) {
   if (x < 0.0)
     return -1.0;
   return 1.0;
 }
 
-static double activate_linear(double x) {
+static INLINE NNFloat activate_linear(NNFloat x, Accuracy accuracy) {
   return x;
 }
 
-static double derive_htan(double x) {
-  if (x > 84.0 || x < -84.0)
-    return 0.0;
-  // 1 / cosh(x)**2
-  // 1 / (0.5 * (e ** x + e ** -x)) ** 2
-  // 4 / (e ** x + e ** -x) ** 2
-  return 4.0 * pow(exp(x) + exp(-x), -2);
+// the derivatives are found from the activation y instead of x, which has
+// already been computed for the forward pass, so they don't need another exp
+
+// 1 / cosh(x)**2 = 1 - tanh(x)**2
+static NNFloat derive_htan(NNFloat y) {
+  return 1.0 - y * y;
 }
 
-static double derive_log(double x) {
-  if (x > 84.0 || x < -84.0)
-    return 0.0;
-  return 2.0 / ((1.0 + exp(-x)) * (1.0 + exp(x)));
+// 2 * s(x) * (1 - s(x)) where y = 2 * s(x) - 1
+static NNFloat derive_log(NNFloat y) {
+  return 0.5 * (1.0 + y) * (1.0 - y);
 }
 
-static double derive_step(double x) {
+static NNFloat derive_step(NNFloat y) {
   return 1.0;
 }
 
-static double derive_linear(double x) {
+static NNFloat derive_linear(NNFloat y) {
   return 1.0;
 }
 
-double learn() {
-  double mse = 0.0;
-  int i, j, k, l;
-  unsigned int startLayer;
-  GLfloat *myWeights;
-  double *myMomentums;
-  double newMSE;
-#ifdef SLOW
-  i = nnData.epoch % nnData.inputsSize;
-  {
-#else
-  for (i = 0; i < nnData.inputsSize; i++) {
-#endif
-    if (i == 0)
-      shuffle();
-    // clear values
-    bzero(nnData.preActivates, nnData.preActivatesSize * sizeof(double));
-    // clear errors
-    bzero(nnData.errors, nnData.errorsSize * sizeof(double));
-    // input values
-    nnData.values[1] = nnData.shuffledInputs[i]->x;
-    nnData.values[2] = nnData.shuffledInputs[i]->y;
-
-    startLayer = 1;
-    if (nnData.isRBF) {
-      int stride = nnData.layerSizes[0] + 1;
-      startLayer++;
-      for (k = 0; k < nnData.layerSizes[1]; k++) {
-        nnData.layerValues[1][k + 1] = exp(-(pow(nnData.layerValues[0][1] - nnData.weights[stride * k], 2) + pow(nnData.layerValues[0][2] - nnData.weights[stride * k + 1], 2)) / (2 * nnData.weights[stride * k + 2]));
-      }
-    }
+// the copy of a layer's values belonging to one sample of the batch
+// every sample gets the same layout as scratch->values
+static NNFloat *batchLayerValues(NNScratch *scratch, int sample, int layer) {
+  return scratch->batchValues + sample * nnData.valuesSize + (scratch->layerValues[layer] - scratch->values);
+}
+
+static NNFloat *batchLayerErrors(NNScratch *scratch, int sample, int layer) {
+  return scratch->batchErrors + sample * nnData.errorsSize + (scratch->layerErrors[layer] - scratch->errors);
+}
 
-    // find outputs - forward
-    // myWeights points to the weights for the current set of inputs and output
-    myWeights = nnData.layerWeights[startLayer - 1];
-    for (j = startLayer; j < nnData.layers; j++) {
-      for (k = 0; k < nnData.layerSizes[j]; k++) {
-        for (l = 0; l < nnData.layerSizes[j - 1] + 1; l++) {
-          nnData.layerPreActivates[j][k] += myWeights[l] * nnData.layerValues[j - 1][l];
+// find the errors for a whole batch - backward
+// blocked the same way as forwardBatch
+static void backwardBatch(NNScratch *scratch, unsigned int startLayer, int count) {
+  int j, k, s, k0, s0;
+  for (j = nnData.layers - 2; j >= (int)startLayer; j--) {
+    int inputs = nnData.layerSizes[j] + 1;
+    for (k0 = 0; k0 < nnData.layerSizes[j + 1]; k0 += BLOCK_NODES) {
+      int kEnd = MIN(k0 + BLOCK_NODES, nnData.layerSizes[j + 1]);
+      for (s0 = 0; s0 < count; s0 += BLOCK_SAMPLES) {
+        int sEnd = MIN(s0 + BLOCK_SAMPLES, count);
+        for (s = s0; s < sEnd; s++) {
+          NNFloat *myErrors = batchLayerErrors(scratch, s, j);
+          NNFloat *nextErrors = batchLayerErrors(scratch, s, j + 1);
+          for (k = k0; k < kEnd; k++) {
+            // sum up errors
+            kernels.backpropagate(myErrors, nnData.layerWeights[j] + k * inputs + 1, nextErrors[k], nnData.layerSizes[j]);
+          }
         }
-        // advance myWeights to the next node
-        myWeights += nnData.layerSizes[j - 1] + 1;
-        // activate!
-        nnData.layerValues[j][k + 1] = nnData.activate(nnData.layerPreActivates[j][k]);
       }
     }
+    PROFILE_ADD_LAYER(scratch, PHASE_BACKWARD, j);
+  }
+}
 
-    // find the errors - backward
-    nnData.errors[nnData.errorsSize - 1] = nnData.shuffledInputs[i]->target - nnData.values[nnData.valuesSize - 1];
-    for (j = nnData.layers - 2; j >= startLayer; j--) {
-      // myWeights here goes something like 6 7 3 4 5 1 2
-      // jump backwards here
-      myWeights = nnData.layerWeights[j];
-      for (k = 0; k < nnData.layerSizes[j + 1]; k++) {
-        for (l = 0; l < nnData.layerSizes[j]; l++) {
-          // sum up errors
-          nnData.layerErrors[j][l] += myWeights[l + 1] * nnData.layerErrors[j + 1][k];
-        }
-        // advance myWeights
-        myWeights += nnData.layerSizes[j] + 1;
-      }
+// the inputs presented in an epoch
+// position i of the epoch is input INPUT_INDEX(inputs, i) of the data
+typedef struct InputOrder {
+  const Dataset *data;
+  // the index in nnData.inputs of the input at each position
+  const unsigned int *order;
+  // set when data has already been copied into that order
+  unsigned char inOrder;
+} InputOrder;
+
+#define INPUT_INDEX(inputs, i) ((inputs)->inOrder ? (i) : (inputs)->order[i])
+
+// find the rbf layer's values for a point, bias included
+// with a cutoff only the centers in the point's grid cell are looked at, and
+// only the ones within the cutoff of those get anything but 0
+static INLINE void evaluateRBF(NNFloat *values, NNFloat x, NNFloat y, Accuracy accuracy) {
+  int stride = nnData.layerSizes[0] + 1;
+  int k;
+  values[0] = 1.0;
+  if (nnData.rbfCutoff > 0.0) {
+    int cell = rbfGridCell(&nnData.rbfGrid, x, y);
+    unsigned int c;
+    bzero(values + 1, nnData.layerSizes[1] * sizeof(NNFloat));
+    if (cell < 0)
+      return;
+    for (c = nnData.rbfGrid.cellStart[cell]; c < nnData.rbfGrid.cellStart[cell + 1]; c++) {
+      const GLfloat *center;
+      NNFloat distance;
+      k = nnData.rbfGrid.cellCenters[c];
+      center = nnData.weights + stride * k;
+      distance = pow(x - center[0], 2) + pow(y - center[1], 2);
+      if (distance <= nnData.rbfCutoff * nnData.rbfCutoff * center[2])
+        values[k + 1] = tieredExp(-distance / (2 * center[2]), accuracy);
+    }
+  } else {
+    for (k = 0; k < nnData.layerSizes[1]; k++) {
+      values[k + 1] = tieredExp(-(pow(x - nnData.weights[stride * k], 2) + pow(y - nnData.weights[stride * k + 1], 2)) / (2 * nnData.weights[stride * k + 2]), accuracy);
+    }
+  }
+}
+
+// the rbf layer's values for the input at a position of the epoch, from the
+// cache if there is one
+static INLINE void rbfLayer(NNFloat *values, const InputOrder *inputs, unsigned int position, NNFloat x, NNFloat y, Accuracy accuracy) {
+  unsigned long long index = inputs->order[position];
+  if (nnData.rbfCache != NULL) {
+    memcpy(values, nnData.rbfCache + index * (nnData.layerSizes[1] + 1), (nnData.layerSizes[1] + 1) * sizeof(NNFloat));
+  } else if (nnData.rbfSparseStart != NULL) {
+    unsigned long long i;
+    values[0] = 1.0;
+    bzero(values + 1, nnData.layerSizes[1] * sizeof(NNFloat));
+    for (i = nnData.rbfSparseStart[index]; i < nnData.rbfSparseStart[index + 1]; i++) {
+      values[nnData.rbfSparseCenters[i] + 1] = nnData.rbfSparseValues[i];
     }
+  } else {
+    evaluateRBF(values, x, y, accuracy);
+  }
+}
+
+// a copy of the training code for every activation function and accuracy
+#define SPECIALIZED(name) name##_htan_exact
+#define ACCURACY ACCURACY_EXACT
+#define ACTIVATE(x) activate_htan(x, ACCURACY)
+#define DERIVE(y) derive_htan(y)
+#include "learntemplate.h"
+
+#define SPECIALIZED(name) name##_htan_fast
+#define ACCURACY ACCURACY_FAST
+#define ACTIVATE(x) activate_htan(x, ACCURACY)
+#define DERIVE(y) derive_htan(y)
+#include "learntemplate.h"
+
+#define SPECIALIZED(name) name##_htan_faster
+#define ACCURACY ACCURACY_FASTER
+#define ACTIVATE(x) activate_htan(x, ACCURACY)
+#define DERIVE(y) derive_htan(y)
+#include "learntemplate.h"
+
+#define SPECIALIZED(name) name##_log_exact
+#define ACCURACY ACCURACY_EXACT
+#define ACTIVATE(x) activate_log(x, ACCURACY)
+#define DERIVE(y) derive_log(y)
+#include "learntemplate.h"
+
+#define SPECIALIZED(name) name##_log_fast
+#define ACCURACY ACCURACY_FAST
+#define ACTIVATE(x) activate_log(x, ACCURACY)
+#define DERIVE(y) derive_log(y)
+#include "learntemplate.h"
+
+#define SPECIALIZED(name) name##_log_faster
+#define ACCURACY ACCURACY_FASTER
+#define ACTIVATE(x) activate_log(x, ACCURACY)
+#define DERIVE(y) derive_log(y)
+#include "learntemplate.h"
+
+#define SPECIALIZED(name) name##_step_exact
+#define ACCURACY ACCURACY_EXACT
+#define ACTIVATE(x) activate_step(x, ACCURACY)
+#define DERIVE(y) derive_step(y)
+#include "learntemplate.h"
+
+#define SPECIALIZED(name) name##_step_fast
+#define ACCURACY ACCURACY_FAST
+#define ACTIVATE(x) activate_step(x, ACCURACY)
+#define DERIVE(y) derive_step(y)
+#include "learntemplate.h"
+
+#define SPECIALIZED(name) name##_step_faster
+#define ACCURACY ACCURACY_FASTER
+#define ACTIVATE(x) activate_step(x, ACCURACY)
+#define DERIVE(y) derive_step(y)
+#include "learntemplate.h"
 
-    // learn - forward
-    // myMomentums and myWeights are the same idea
-    myWeights = nnData.layerWeights[startLayer - 1];
-    myMomentums = nnData.layerMomentums[startLayer - 1];
-    for (j = startLayer; j < nnData.layers; j++) {
-      for (k = 0; k < nnData.layerSizes[j]; k++) {
-        double delta = nnData.derive(nnData.layerPreActivates[j][k]) * nnData.layerErrors[j][k] * nnData.learnRate;
-        for (l = 0; l < nnData.layerSizes[j - 1] + 1; l++) {
-          // calculate the change into the momentum term
-          myMomentums[l] = delta * nnData.layerValues[j - 1][l] + nnData.momentum * myMomentums[l];
-          // update the weight
-          myWeights[l] += myMomentums[l];
+#define SPECIALIZED(name) name##_linear_exact
+#define ACCURACY ACCURACY_EXACT
+#define ACTIVATE(x) activate_linear(x, ACCURACY)
+#define DERIVE(y) derive_linear(y)
+#include "learntemplate.h"
+
+#define SPECIALIZED(name) name##_linear_fast
+#define ACCURACY ACCURACY_FAST
+#define ACTIVATE(x) activate_linear(x, ACCURACY)
+#define DERIVE(y) derive_linear(y)
+#include "learntemplate.h"
+
+#define SPECIALIZED(name) name##_linear_faster
+#define ACCURACY ACCURACY_FASTER
+#define ACTIVATE(x) activate_linear(x, ACCURACY)
+#define DERIVE(y) derive_linear(y)
+#include "learntemplate.h"
+
+// the copies for one activation function and accuracy
+typedef struct Trainer {
+  double (*learnSample)(NNScratch *scratch, const InputOrder *inputs, unsigned int position);
+  double (*batchGradients)(NNScratch *scratch, const InputOrder *inputs, unsigned int first, int count, NNFloat *gradients);
+  NNFloat (*evaluate)(NNScratch *scratch, NNFloat x, NNFloat y);
+} Trainer;
+
+// indexed by Accuracy
+static const Trainer htanTrainers[] = {
+  {&learnSample_htan_exact, &batchGradients_htan_exact, &evaluate_htan_exact},
+  {&learnSample_htan_fast, &batchGradients_htan_fast, &evaluate_htan_fast},
+  {&learnSample_htan_faster, &batchGradients_htan_faster, &evaluate_htan_faster}
+};
+static const Trainer logTrainers[] = {
+  {&learnSample_log_exact, &batchGradients_log_exact, &evaluate_log_exact},
+  {&learnSample_log_fast, &batchGradients_log_fast, &evaluate_log_fast},
+  {&learnSample_log_faster, &batchGradients_log_faster, &evaluate_log_faster}
+};
+static const Trainer stepTrainers[] = {
+  {&learnSample_step_exact, &batchGradients_step_exact, &evaluate_step_exact},
+  {&learnSample_step_fast, &batchGradients_step_fast, &evaluate_step_fast},
+  {&learnSample_step_faster, &batchGradients_step_faster, &evaluate_step_faster}
+};
+static const Trainer linearTrainers[] = {
+  {&learnSample_linear_exact, &batchGradients_linear_exact, &evaluate_linear_exact},
+  {&learnSample_linear_fast, &batchGradients_linear_fast, &evaluate_linear_fast},
+  {&learnSample_linear_faster, &batchGradients_linear_faster, &evaluate_linear_faster}
+};
+
+// the copy picked by initNN
+static const Trainer *trainer;
+
+#ifndef SLOW
+// update every trainable weight once with the summed changes
+// gradients, momentums and weights share a layout so this is one pass
+static void applyGradients(NNFloat *gradients, unsigned int startLayer) {
+  int first = nnData.layerWeights[startLayer - 1] - nnData.weights;
+  // the gradients already include the learn rate
+  kernels.update(nnData.weights + first, nnData.momentums + first, gradients + first, 1.0, nnData.momentum, nnData.weightsSize - first);
+}
+
+// present a batch of inputs and update the weights once
+// with a batch of one this does the same thing as learnSample
+// returns the contribution of the batch to the mse
+static double learnBatch(NNScratch *scratch, const InputOrder *inputs, unsigned int first, int count) {
+  double mse = trainer->batchGradients(scratch, inputs, first, count, scratch->gradients);
+  applyGradients(scratch->gradients, nnData.isRBF ? 2 : 1);
+  PROFILE_ADD(scratch, PHASE_UPDATE);
+  return mse;
+}
+
+// a batch being learned by all the threads together with -d
+typedef struct SharedBatch {
+  const InputOrder *inputs;
+  unsigned int first;
+  int count;
+  int shards;
+} SharedBatch;
+
+// find the gradients for every shard of the batch
+// the shards are dealt out to the threads, but each shard's sum only depends
+// on the inputs in it
+static void learnShards(unsigned int thread, void *arg) {
+  SharedBatch *batch = (SharedBatch *)arg;
+  int shard;
+  for (shard = thread; shard < batch->shards; shard += nnData.threads) {
+    int first = shard * SHARD_SIZE;
+    nnData.shardMSE[shard] = trainer->batchGradients(nnData.scratch + thread, batch->inputs, batch->first + first, MIN(SHARD_SIZE, batch->count - first), nnData.shardGradients + shard * nnData.weightsSize);
+  }
+}
+
+// add up the shards' gradients and update the weights
+// every weight is summed in the same tree(0+1, 2+3, then 0+2, ...) and the
+// weights are dealt out to the threads in fixed chunks, so nothing about the
+// arithmetic depends on how many threads there are
+static void applyShards(unsigned int thread, void *arg) {
+  SharedBatch *batch = (SharedBatch *)arg;
+  int first = nnData.layerWeights[nnData.isRBF ? 1 : 0] - nnData.weights;
+  int start;
+  PROFILE_MARK(nnData.scratch + thread);
+  for (start = first + thread * REDUCE_CHUNK; start < nnData.weightsSize; start += nnData.threads * REDUCE_CHUNK) {
+    int count = MIN(REDUCE_CHUNK, nnData.weightsSize - start);
+    int stride, shard, i;
+    for (stride = 1; stride < batch->shards; stride *= 2) {
+      for (shard = 0; shard + stride < batch->shards; shard += 2 * stride) {
+        NNFloat *sum = nnData.shardGradients + shard * nnData.weightsSize + start;
+        NNFloat *other = nnData.shardGradients + (shard + stride) * nnData.weightsSize + start;
+        for (i = 0; i < count; i++) {
+          sum[i] += other[i];
         }
-        // advance pointers
-        myWeights += nnData.layerSizes[j - 1] + 1;
-        myMomentums += nnData.layerSizes[j - 1] + 1;
       }
     }
-    // add error to total
-    mse += 0.25 * pow(nnData.errors[nnData.errorsSize - 1], 2);
-#if 0
-    // print tons of information
-    // will slow things down a lot
-    printf("values:\n");
-    for (j = 0; j < nnData.valuesSize; j++) {
-      printf("%f\n", nnData.values[j]);
+    kernels.update(nnData.weights + start, nnData.momentums + start, nnData.shardGradients + start, 1.0, nnData.momentum, count);
+  }
+  PROFILE_ADD(nnData.scratch + thread, PHASE_UPDATE);
+}
+
+// present a batch of inputs split between all the threads and update the
+// weights once, coming up with exactly the same weights for any number of threads
+// returns the contribution of the batch to the mse
+static double learnBatchTogether(const InputOrder *inputs, unsigned int first, int count) {
+  SharedBatch batch;
+  double mse = 0.0;
+  int shard;
+  batch.inputs = inputs;
+  batch.first = first;
+  batch.count = count;
+  batch.shards = (count + SHARD_SIZE - 1) / SHARD_SIZE;
+  runPool(&pool, &learnShards, &batch);
+  runPool(&pool, &applyShards, &batch);
+  // add up the errors in order too
+  for (shard = 0; shard < batch.shards; shard++) {
+    mse += nnData.shardMSE[shard];
+  }
+  return mse;
+}
+
+// train one thread's share of the shuffled inputs
+static void learnSlice(unsigned int thread, void *arg) {
+  const InputOrder *inputs = (const InputOrder *)arg;
+  NNScratch *scratch = nnData.scratch + thread;
+  // split the inputs as evenly as possible
+  unsigned int start = (unsigned long long)inputs->data->size * thread / nnData.threads;
+  unsigned int end = (unsigned long long)inputs->data->size * (thread + 1) / nnData.threads;
+  unsigned int i;
+  scratch->mse = 0.0;
+  if (nnData.batchSize > 1) {
+    for (i = start; i < end; i += nnData.batchSize) {
+      scratch->mse += learnBatch(scratch, inputs, i, MIN(nnData.batchSize, end - i));
+    }
+  } else {
+    for (i = start; i < end; i++) {
+      scratch->mse += trainer->learnSample(scratch, inputs, i);
+    }
+  }
+}
+
+// present every input once in the order given
+// returns the summed mse
+static double learnInputs(const InputOrder *inputs) {
+  double mse = 0.0;
+  unsigned int i;
+  if (nnData.deterministic) {
+    // every batch is split between the threads
+    for (i = 0; i < inputs->data->size; i += nnData.batchSize) {
+      mse += learnBatchTogether(inputs, i, MIN(nnData.batchSize, inputs->data->size - i));
     }
-    printf("errors:\n");
-    for (j = 0; j < nnData.errorsSize; j++) {
-      printf("%f\n", nnData.errors[j]);
+  } else {
+    // every thread works through its own slice of the inputs
+    // runPool doesn't return until they're all done, so the momentum is only
+    // adjusted once everything has been seen
+    runPool(&pool, &learnSlice, (void *)inputs);
+    for (i = 0; i < nnData.threads; i++) {
+      mse += nnData.scratch[i].mse;
     }
-    printf("momentums:\n");
-    for (j = 0; j < nnData.weightsSize; j++) {
-      printf("%f\n", nnData.momentums[j]);
+  }
+  return mse;
+}
+
+// shuffle the order the blocks are read in
+static void shuffleBlocks() {
+  unsigned int i;
+  for (i = 0; i + 1 < nnData.streamBlockCount; i++) {
+    unsigned int offset = i + randomBelow(&nnData.rng, nnData.streamBlockCount - i);
+    unsigned int block = nnData.streamBlocks[i];
+    nnData.streamBlocks[i] = nnData.streamBlocks[offset];
+    nnData.streamBlocks[offset] = block;
+  }
+}
+
+// a block training and the next one being read
+typedef struct StreamStep {
+  InputOrder inputs;
+  unsigned int next;
+  double mse;
+} StreamStep;
+
+static void streamStep(unsigned int thread, void *arg) {
+  StreamStep *step = (StreamStep *)arg;
+  if (thread == 0) {
+    step->mse = learnInputs(&step->inputs);
+  } else {
+    readDatasetBlock(&nnData.stream, nnData.streamBuffers + 1 - nnData.streamCurrent, step->next * nnData.streamBlock, nnData.streamBlock);
+  }
+}
+
+// present every input on disk once, a block at a time
+// returns the summed mse
+static double learnStream() {
+  StreamStep step;
+  double mse = 0.0;
+  unsigned int b, i;
+  for (b = 0; b < nnData.streamBlockCount; b++) {
+    Dataset *block = nnData.streamBuffers + nnData.streamCurrent;
+    // shuffle inside the block
+    PROFILE_MARK(nnData.scratch);
+    for (i = 0; i < block->size; i++) {
+      nnData.streamOrder[i] = i;
     }
-    printf("weights:\n");
-    for (j = 0; j < nnData.weightsSize; j++) {
-      printf("%f\n", nnData.weights[j]);
+    for (i = 0; i + 1 < block->size; i++) {
+      unsigned int offset = i + randomBelow(&nnData.rng, block->size - i);
+      unsigned int index = nnData.streamOrder[i];
+      nnData.streamOrder[i] = nnData.streamOrder[offset];
+      nnData.streamOrder[offset] = index;
     }
+    PROFILE_ADD(nnData.scratch, PHASE_SHUFFLE);
+    step.inputs.data = block;
+    step.inputs.order = nnData.streamOrder;
+    step.inputs.inOrder = 0;
+    // the last block of an epoch reads the first block of the next one
+    if (b + 1 == nnData.streamBlockCount)
+      shuffleBlocks();
+    step.next = nnData.streamBlocks[(b + 1) % nnData.streamBlockCount];
+    runPool(&streamPool, &streamStep, &step);
+    mse += step.mse;
+    nnData.streamCurrent = 1 - nnData.streamCurrent;
+  }
+  return mse;
+}
+#endif
+
+double learn() {
+  double mse = 0.0;
+#ifdef SLOW
+  int i;
 #endif
+  double newMSE;
+  InputOrder inputs;
+#ifdef PROFILE
+  unsigned long long profileStart = profileTicks();
+#endif
+  // read the copy if there is one, otherwise go through the shuffled indices
+  inputs.data = nnData.shuffleCopy ? &nnData.shuffledInputs : &nnData.inputs;
+  inputs.order = nnData.order;
+  inputs.inOrder = nnData.shuffleCopy;
+#ifdef SLOW
+  // one input per call, so there is never more than one in a batch or thread
+  i = nnData.epoch % nnData.inputs.size;
+  if (i == 0)
+    shuffle();
+  mse += trainer->learnSample(nnData.scratch, &inputs, i);
+#else
+  if (nnData.streamBlock > 0) {
+    mse = learnStream();
+  } else {
+    shuffle();
+    mse = learnInputs(&inputs);
   }
+#endif
   nnData.epoch++;
 #ifdef SLOW
   newMSE = mse;
 #else
-  newMSE = mse / nnData.inputsSize;
+  newMSE = mse / (nnData.streamBlock > 0 ? nnData.stream.size : nnData.inputs.size);
 
   // adjust momentum
   // http://ieeexplore.ieee.org/xpls/abs_all.jsp?arnumber=141697
@@ -269,96 +594,505 @@ double learn() {
 #endif
 
   nnData.lastMSE = newMSE;
+#ifdef PROFILE
+  nnData.profileLearn += profileTicks() - profileStart;
+#ifdef SLOW
+  nnData.profileInputs++;
+#else
+  nnData.profileInputs += nnData.streamBlock > 0 ? nnData.stream.size : nnData.inputs.size;
+#endif
+#endif
   return nnData.lastMSE;
 }
 
-static void cluster() {
-  int i;
-  int j;
-  int stride = nnData.layerSizes[0] + 1;
-  int *assignments = malloc(nnData.inputsSize * sizeof(int));
-  int *oldAssignments = malloc(nnData.inputsSize * sizeof(int));
-  double *newMeans = malloc(nnData.layerSizes[0] * nnData.layerSizes[1] * sizeof(double));
-  unsigned int *assigned = malloc(nnData.layerSizes[1] * sizeof(unsigned int));
-  char done = 0;
-  shuffle();
-  bzero(oldAssignments, nnData.inputsSize * sizeof(int));
-  // randomly select starting points
-  for (i = 0; i < nnData.layerSizes[1]; i++) {
-    nnData.weights[i * stride] = nnData.shuffledInputs[i]->x;
-    nnData.weights[i * stride + 1] = nnData.shuffledInputs[i]->y;
-    // init variance
-    nnData.weights[i * stride + 2] = 0.0;
-  }
-  // organize into clusters
-  while (!done) {
-    done = 1;
-    bzero(newMeans, nnData.layerSizes[0] * nnData.layerSizes[1] * sizeof(double));
-    bzero(assigned, nnData.layerSizes[1] * sizeof(unsigned int));
-    bzero(assignments, nnData.inputsSize * sizeof(int));
-    for (i = 0; i < nnData.inputsSize; i++) {
-      double distance = hypot(nnData.inputs[i].x - nnData.weights[0], nnData.inputs[i].y - nnData.weights[1]);
-      for (j = 1; j < nnData.layerSizes[1]; j++) {
-        double ndistance = hypot(nnData.inputs[i].x - nnData.weights[j * stride], nnData.inputs[i].y - nnData.weights[j * stride + 1]);
-        if (ndistance < distance) {
-          assignments[i] = j;
-          distance = ndistance;
-        }
+#ifdef PROFILE
+void reportProfile() {
+  unsigned long long phases[PHASE_COUNT];
+  unsigned long long *layers;
+  double perInput;
+  unsigned int t, l;
+  int p;
+  if (nnData.profileEpochs == 0 || nnData.epoch % nnData.profileEpochs != 0 || nnData.profileInputs == 0)
+    return;
+  // add up the threads and start them over
+  layers = (unsigned long long *)calloc(PHASE_LAYERED * nnData.layers, sizeof(unsigned long long));
+  bzero(phases, sizeof(phases));
+  for (t = 0; t < nnData.threads; t++) {
+    NNScratch *scratch = nnData.scratch + t;
+    for (p = 0; p < PHASE_COUNT; p++) {
+      phases[p] += scratch->phaseTime[p];
+    }
+    for (l = 0; l < PHASE_LAYERED * nnData.layers; l++) {
+      layers[l] += scratch->layerTime[l];
+    }
+    bzero(scratch->phaseTime, sizeof(scratch->phaseTime));
+    bzero(scratch->layerTime, PHASE_LAYERED * nnData.layers * sizeof(unsigned long long));
+  }
+  perInput = 1.0 / nnData.profileInputs;
+  // learn is wall time, the phases are added up over the threads
+  printf(PROFILE_UNIT " per input: learn %.1f", nnData.profileLearn * perInput);
+  for (p = 0; p < PHASE_COUNT; p++) {
+    printf(", %s %.1f", phaseNames[p], phases[p] * perInput);
+    if (p < PHASE_LAYERED) {
+      // layer 0 is the inputs, which don't take any time of their own
+      printf(" [");
+      for (l = 1; l < nnData.layers; l++) {
+        printf(l > 1 ? " %.1f" : "%.1f", layers[p * nnData.layers + l] * perInput);
       }
-      done &= oldAssignments[i] == assignments[i];
-      newMeans[nnData.layerSizes[0] * assignments[i]] += nnData.inputs[i].x;
-      newMeans[nnData.layerSizes[0] * assignments[i] + 1] += nnData.inputs[i].y;
-      assigned[assignments[i]]++;
+      printf("]");
+    }
+  }
+  printf("\n");
+  free(layers);
+  nnData.profileLearn = 0;
+  nnData.profileInputs = 0;
+}
+#endif
+
+// how many inputs one thread classified correctly
+typedef struct AccuracySlice {
+  unsigned int correct;
+  // keeps the threads' counts on different cache lines
+  char padding[60];
+} AccuracySlice;
+
+static void accuracySlice(unsigned int thread, void *arg) {
+  AccuracySlice *slices = (AccuracySlice *)arg;
+  unsigned int start = (unsigned long long)nnData.inputs.size * thread / nnData.threads;
+  unsigned int end = (unsigned long long)nnData.inputs.size * (thread + 1) / nnData.threads;
+  unsigned int i;
+  slices[thread].correct = 0;
+  for (i = start; i < end; i++) {
+    // every activation function puts the classes on either side of 0
+    NNFloat output = trainer->evaluate(nnData.scratch + thread, nnData.inputs.x[i], nnData.inputs.y[i]);
+    if ((output >= 0.0) == (nnData.inputs.target[i] > 0))
+      slices[thread].correct++;
+  }
+}
+
+double accuracy() {
+  AccuracySlice *slices = (AccuracySlice *)malloc(nnData.threads * sizeof(AccuracySlice));
+  unsigned int correct = 0;
+  unsigned int i;
+  runPool(&pool, &accuracySlice, slices);
+  for (i = 0; i < nnData.threads; i++) {
+    correct += slices[i].correct;
+  }
+  free(slices);
+  return (double)correct / nnData.inputs.size;
+}
+
+// place the rbf centers with k-means, or load the ones placed last time
+static void cluster(const char *file) {
+  int stride = nnData.layerSizes[0] + 1;
+  CenterKey key;
+  char *path = NULL;
+  // clustering gets its own stream of random numbers, so the rest of the run
+  // gets the same ones whether the centers are loaded or not, and the centers
+  // only depend on what's in the key and not on how many weights came first
+  Rng rng;
+  seedRng(&rng, nnData.seed, CLUSTER_STREAM);
+  if (nnData.cacheCenters) {
+    key.dataHash = hashDataset(&nnData.inputs);
+    key.seed = nnData.seed;
+    key.count = nnData.layerSizes[1];
+    key.algorithm = nnData.kmeansAlgorithm;
+    key.seeding = nnData.kmeansSeeding;
+    path = centerCachePath(file, &key);
+    if (loadCenters(path, &key, nnData.weights, stride)) {
+      free(path);
+      return;
     }
-    for (i = 0; i < nnData.layerSizes[1]; i++) {
-      for (j = 0; j < nnData.layerSizes[0]; j++) {
-        nnData.weights[i * stride + j] = newMeans[i * nnData.layerSizes[0] + j] / assigned[i];
+  }
+  seedCenters(nnData.weights, stride, nnData.layerSizes[1], &nnData.inputs, nnData.kmeansSeeding, &rng, &pool);
+  if (nnData.streamBlock > 0) {
+    // the first block only seeds them, the batches come from the whole file
+    rewindDatasetStream(&nnData.stream);
+    miniBatchKMeans(nnData.weights, stride, nnData.layerSizes[1], &nnData.stream, MINIBATCH_SIZE, MINIBATCH_LIMIT, MINIBATCH_TOLERANCE, &rng);
+  } else if (nnData.kmeansAlgorithm == KMEANS_MINIBATCH) {
+    DatasetStream stream;
+    streamDataset(&stream, &nnData.inputs);
+    miniBatchKMeans(nnData.weights, stride, nnData.layerSizes[1], &stream, MINIBATCH_SIZE, MINIBATCH_LIMIT, MINIBATCH_TOLERANCE, &rng);
+  } else {
+    kmeans(nnData.weights, stride, nnData.layerSizes[1], &nnData.inputs, nnData.kmeansAlgorithm, &pool);
+  }
+  if (path != NULL) {
+    // no room to save them just means clustering again next time
+    saveCenters(path, &key, nnData.weights, stride);
+    free(path);
+  }
+}
+
+// fill in one thread's share of the rbf cache
+// with a cutoff this runs twice, first to count each input's nonzero values
+// into rbfSparseStart and then to fill them in
+static void cacheRBFSlice(unsigned int thread, void *arg) {
+  int rowSize = nnData.layerSizes[1] + 1;
+  unsigned int start = (unsigned long long)nnData.inputs.size * thread / nnData.threads;
+  unsigned int end = (unsigned long long)nnData.inputs.size * (thread + 1) / nnData.threads;
+  NNFloat *row = nnData.scratch[thread].values;
+  unsigned int i;
+  int k;
+  for (i = start; i < end; i++) {
+    if (nnData.rbfCache != NULL) {
+      evaluateRBF(nnData.rbfCache + (unsigned long long)i * rowSize, nnData.inputs.x[i], nnData.inputs.y[i], ACCURACY_EXACT);
+    } else {
+      unsigned long long next = nnData.rbfSparseValues != NULL ? nnData.rbfSparseStart[i] : 0;
+      evaluateRBF(row, nnData.inputs.x[i], nnData.inputs.y[i], ACCURACY_EXACT);
+      for (k = 0; k < nnData.layerSizes[1]; k++) {
+        if (row[k + 1] != 0.0) {
+          if (nnData.rbfSparseValues != NULL) {
+            nnData.rbfSparseCenters[next] = k;
+            nnData.rbfSparseValues[next] = row[k + 1];
+          }
+          next++;
+        }
       }
+      if (nnData.rbfSparseValues == NULL)
+        nnData.rbfSparseStart[i + 1] = next;
     }
-    if (!done) {
-      int *t = assignments;
-      assignments = oldAssignments;
-      oldAssignments = t;
+  }
+}
+
+// the rbf layer never learns, so once it's clustered its values for each
+// input never change and can be worked out ahead of time
+// if they would take more than the limit they're computed every time instead
+static void cacheRBF() {
+  unsigned long long size = (unsigned long long)nnData.inputs.size * (nnData.layerSizes[1] + 1) * sizeof(NNFloat);
+  unsigned long long limit = (unsigned long long)nnData.rbfCacheLimit * 1024 * 1024;
+  unsigned int i;
+  nnData.rbfCache = NULL;
+  nnData.rbfSparseStart = NULL;
+  nnData.rbfSparseCenters = NULL;
+  nnData.rbfSparseValues = NULL;
+  if (nnData.rbfCutoff <= 0.0) {
+    // every center for every input
+    if (size > limit || size != (size_t)size)
+      return;
+    nnData.rbfCache = (NNFloat *)malloc(size);
+    if (nnData.rbfCache == NULL)
+      return;
+    runPool(&pool, &cacheRBFSlice, NULL);
+    return;
+  }
+  // just the centers within the cutoff
+  size = (nnData.inputs.size + 1ULL) * sizeof(unsigned long long);
+  if (size > limit || size != (size_t)size)
+    return;
+  nnData.rbfSparseStart = (unsigned long long *)malloc(size);
+  if (nnData.rbfSparseStart == NULL)
+    return;
+  nnData.rbfSparseStart[0] = 0;
+  runPool(&pool, &cacheRBFSlice, NULL);
+  for (i = 0; i < nnData.inputs.size; i++) {
+    nnData.rbfSparseStart[i + 1] += nnData.rbfSparseStart[i];
+  }
+  size += nnData.rbfSparseStart[nnData.inputs.size] * (sizeof(unsigned int) + sizeof(NNFloat));
+  if (size <= limit && size == (size_t)size) {
+    nnData.rbfSparseCenters = (unsigned int *)malloc(nnData.rbfSparseStart[nnData.inputs.size] * sizeof(unsigned int) + 1);
+    nnData.rbfSparseValues = (NNFloat *)malloc(nnData.rbfSparseStart[nnData.inputs.size] * sizeof(NNFloat) + 1);
+  }
+  if (nnData.rbfSparseCenters == NULL || nnData.rbfSparseValues == NULL) {
+    free(nnData.rbfSparseStart);
+    free(nnData.rbfSparseCenters);
+    free(nnData.rbfSparseValues);
+    nnData.rbfSparseStart = NULL;
+    nnData.rbfSparseCenters = NULL;
+    nnData.rbfSparseValues = NULL;
+    return;
+  }
+  runPool(&pool, &cacheRBFSlice, NULL);
+}
+
+static void initScratch(NNScratch *scratch) {
+  int i;
+  // allocate our arrays
+  scratch->values = (NNFloat *)malloc(nnData.valuesSize * sizeof(NNFloat));
+  scratch->errors = (NNFloat *)malloc(nnData.errorsSize * sizeof(NNFloat));
+  scratch->batchValues = (NNFloat *)malloc(nnData.batchSize * nnData.valuesSize * sizeof(NNFloat));
+  scratch->batchErrors = (NNFloat *)malloc(nnData.batchSize * nnData.errorsSize * sizeof(NNFloat));
+  scratch->gradients = (NNFloat *)malloc(nnData.weightsSize * sizeof(NNFloat));
+
+  // allocate convenience arrays
+  scratch->layerValues = (NNFloat **)malloc(nnData.layers * sizeof(NNFloat *));
+  scratch->layerErrors = (NNFloat **)malloc(nnData.layers * sizeof(NNFloat *));
+  // initialize convenience arrays
+  scratch->layerValues[0] = scratch->values;
+  // this is a bogus value because the input layer does not have errors
+  // it needs populated because the other layers are offsets from the first
+  scratch->layerErrors[0] = scratch->errors - nnData.layerSizes[0];
+  if (nnData.isRBF) {
+    scratch->layerErrors[0] -= nnData.layerSizes[1];
+  }
+  for (i = 1; i < nnData.layers; i++) {
+    scratch->layerValues[i] = scratch->layerValues[i - 1] + nnData.layerSizes[i - 1] + 1;
+    scratch->layerErrors[i] = scratch->layerErrors[i - 1] + nnData.layerSizes[i - 1];
+  }
+  // change the bogus values to nulls
+  scratch->layerErrors[0] = NULL;
+  if (nnData.isRBF) {
+    scratch->layerErrors[1] = NULL;
+  }
+
+  // initialize biases
+  for (i = 0; i < nnData.layers; i++) {
+    int j;
+    scratch->layerValues[i][0] = 1.0;
+    for (j = 0; j < nnData.batchSize; j++) {
+      batchLayerValues(scratch, j, i)[0] = 1.0;
     }
   }
-  // find variance
-  for (i = 0; i < nnData.inputsSize; i++) {
-    nnData.weights[assignments[i] * stride + 2] += pow(nnData.inputs[i].x - nnData.weights[assignments[i] * stride], 2) + pow(nnData.inputs[i].y - nnData.weights[assignments[i] * stride + 1], 2);
+#ifdef PROFILE
+  scratch->profileMark = 0;
+  scratch->profileCalls = 0;
+  bzero(scratch->phaseTime, sizeof(scratch->phaseTime));
+  scratch->layerTime = (unsigned long long *)calloc(PHASE_LAYERED * nnData.layers, sizeof(unsigned long long));
+#endif
+}
+
+static void freeScratch(NNScratch *scratch) {
+  free(scratch->values);
+  free(scratch->errors);
+  free(scratch->batchValues);
+  free(scratch->batchErrors);
+  free(scratch->gradients);
+  free(scratch->layerValues);
+  free(scratch->layerErrors);
+#ifdef PROFILE
+  free(scratch->layerTime);
+#endif
+}
+
+#ifndef SLOW
+// get ready to train from a binary training set a block at a time instead of
+// loading it, see streamBlock
+static void openTrainingStream(const char *file) {
+  char *binary = (char *)malloc(strlen(file) + 5);
+  unsigned int i;
+  sprintf(binary, "%s.bin", file);
+  // a text file can't be read out of order, but its sidecar can
+  if (!openBinaryDatasetStream(&nnData.stream, file, NULL) && !openBinaryDatasetStream(&nnData.stream, binary, file)) {
+    fprintf(stderr, "Can't read %s a block at a time, convert it with datconvert first.\n", file);
+    exit(1);
+  }
+  free(binary);
+  if (nnData.stream.size == 0) {
+    fprintf(stderr, "%s has no inputs.\n", file);
+    exit(1);
   }
-  for (i = 0; i < nnData.layerSizes[1]; i++) {
-    nnData.weights[i * stride + 2] /= assigned[i];
-    nnData.weights[i * stride + 2] += 0.01;
+  if (nnData.streamBlock > nnData.stream.size)
+    nnData.streamBlock = nnData.stream.size;
+  nnData.streamBlockCount = (nnData.stream.size + nnData.streamBlock - 1) / nnData.streamBlock;
+  nnData.streamBlocks = (unsigned int *)malloc(nnData.streamBlockCount * sizeof(unsigned int));
+  for (i = 0; i < nnData.streamBlockCount; i++) {
+    nnData.streamBlocks[i] = i;
   }
-  // free memory
-  free(newMeans);
-  free(oldAssignments);
-  free(assignments);
-  free(assigned);
+  nnData.streamOrder = (unsigned int *)malloc(nnData.streamBlock * sizeof(unsigned int));
+  allocateDataset(&nnData.streamBuffers[0], nnData.streamBlock);
+  allocateDataset(&nnData.streamBuffers[1], nnData.streamBlock);
+  // the first block stands in for the whole set everywhere else
+  allocateDataset(&nnData.inputs, nnData.streamBlock);
+  readDatasetBlock(&nnData.stream, &nnData.inputs, 0, nnData.streamBlock);
+  // only minibatch k-means reads the inputs a piece at a time, and hashing the
+  // whole file for the center cache would read it all again
+  nnData.kmeansAlgorithm = KMEANS_MINIBATCH;
+  nnData.cacheCenters = 0;
+  // each block is shuffled through its own order instead
+  nnData.shuffleCopy = 0;
+  // the reading thread is kept for the next initNN
+  if (streamPool.threads != 2)
+    initPool(&streamPool, 2);
+  nnData.streamCurrent = 0;
+  shuffleBlocks();
+  readDatasetBlock(&nnData.stream, &nnData.streamBuffers[0], nnData.streamBlocks[0] * nnData.streamBlock, nnData.streamBlock);
+}
+#endif
+
+void consumeArguments(int *argc, char **argv, int count) {
+  memmove(argv + 1, argv + 1 + count, (*argc - 1 - count) * sizeof(char *));
+  (*argc) -= count;
 }
 
 void initNN(int *argc, char **argv) {
   int i;
+  char *file = "spiral.dat";
+  char *kernelsName = NULL;
+
+  nnData.isRBF = 0;
+  nnData.batchSize = 1;
+  nnData.threads = 1;
+  nnData.deterministic = 0;
+  nnData.accuracy = ACCURACY_EXACT;
+  nnData.shuffleCopy = 0;
+  nnData.seed = 1;
+  nnData.rbfCache = NULL;
+  nnData.rbfCacheLimit = 1024;
+  nnData.rbfCutoff = 0.0;
+  nnData.kmeansAlgorithm = KMEANS_HAMERLY;
+  nnData.kmeansSeeding = KMEANS_SEED_PLUSPLUS;
+  nnData.cacheCenters = 1;
+  nnData.streamBlock = 0;
+#ifdef PROFILE
+  nnData.profileEpochs = 100;
+  nnData.profileLearn = 0;
+  nnData.profileInputs = 0;
+#endif
+
+  // options come before the layer sizes
+  // they are removed from the command line so they aren't processed later
+  while (*argc > 1 && argv[1][0] == '-') {
+    if (*argc > 2 && !strcmp(argv[1], "-f")) {
+      // we got a file from the command line
+      file = argv[2];
+      consumeArguments(argc, argv, 2);
+    } else if (!strcmp(argv[1], "-r")) {
+      nnData.isRBF = 1;
+      consumeArguments(argc, argv, 1);
+    } else if (*argc > 2 && !strcmp(argv[1], "-b")) {
+      // update the weights once per this many inputs
+      nnData.batchSize = atoi(argv[2]);
+      if (nnData.batchSize < 1)
+        nnData.batchSize = 1;
+      consumeArguments(argc, argv, 2);
+    } else if (*argc > 2 && !strcmp(argv[1], "-t")) {
+      // train with this many threads at once
+      nnData.threads = atoi(argv[2]);
+      if (nnData.threads < 1)
+        nnData.threads = 1;
+      consumeArguments(argc, argv, 2);
+    } else if (!strcmp(argv[1], "-d")) {
+      // split every batch between the threads instead of every epoch
+      nnData.deterministic = 1;
+      consumeArguments(argc, argv, 1);
+    } else if (*argc > 2 && !strcmp(argv[1], "-x")) {
+      // use these kernels instead of the widest ones the cpu supports
+      kernelsName = argv[2];
+      consumeArguments(argc, argv, 2);
+    } else if (*argc > 2 && (!strcmp(argv[1], "-s") || !strcmp(argv[1], "--seed"))) {
+      // start the random numbers somewhere else
+      nnData.seed = strtoull(argv[2], NULL, 10);
+      consumeArguments(argc, argv, 2);
+    } else if (*argc > 2 && !strcmp(argv[1], "-m")) {
+      // let the rbf cache use this many megabytes
+      nnData.rbfCacheLimit = atoi(argv[2]);
+      consumeArguments(argc, argv, 2);
+    } else if (*argc > 2 && !strcmp(argv[1], "-c")) {
+      // leave out rbf centers this many standard deviations away
+      nnData.rbfCutoff = atof(argv[2]);
+      consumeArguments(argc, argv, 2);
+    } else if (*argc > 2 && !strcmp(argv[1], "-k")) {
+      // cluster the rbf centers another way
+      if (!strcmp(argv[2], "lloyd")) {
+        nnData.kmeansAlgorithm = KMEANS_LLOYD;
+      } else if (!strcmp(argv[2], "hamerly")) {
+        nnData.kmeansAlgorithm = KMEANS_HAMERLY;
+      } else if (!strcmp(argv[2], "minibatch")) {
+        nnData.kmeansAlgorithm = KMEANS_MINIBATCH;
+      } else {
+        fprintf(stderr, "Unknown k-means algorithm %s\n", argv[2]);
+        exit(1);
+      }
+      consumeArguments(argc, argv, 2);
+    } else if (*argc > 2 && !strcmp(argv[1], "-i")) {
+      // start the rbf centers another way
+      if (!strcmp(argv[2], "random")) {
+        nnData.kmeansSeeding = KMEANS_SEED_RANDOM;
+      } else if (!strcmp(argv[2], "plusplus")) {
+        nnData.kmeansSeeding = KMEANS_SEED_PLUSPLUS;
+      } else if (!strcmp(argv[2], "parallel")) {
+        nnData.kmeansSeeding = KMEANS_SEED_PARALLEL;
+      } else {
+        fprintf(stderr, "Unknown k-means seeding %s\n", argv[2]);
+        exit(1);
+      }
+      consumeArguments(argc, argv, 2);
+    } else if (!strcmp(argv[1], "-n")) {
+      // cluster every time without saving the centers
+      nnData.cacheCenters = 0;
+      consumeArguments(argc, argv, 1);
+    } else if (*argc > 2 && !strcmp(argv[1], "-O")) {
+      // leave the training set on disk and read it this many inputs at a time
+      nnData.streamBlock = atoi(argv[2]);
+      consumeArguments(argc, argv, 2);
+#ifdef PROFILE
+    } else if (*argc > 2 && !strcmp(argv[1], "-P")) {
+      // say where the time went every this many epochs
+      nnData.profileEpochs = atoi(argv[2]);
+      consumeArguments(argc, argv, 2);
+#endif
+    } else if (!strcmp(argv[1], "-p")) {
+      // copy the inputs into the shuffled order every epoch
+      nnData.shuffleCopy = 1;
+      consumeArguments(argc, argv, 1);
+    } else if (*argc > 2 && !strcmp(argv[1], "-a")) {
+      // trade some accuracy in exp and the activation functions for speed
+      if (!strcmp(argv[2], "exact")) {
+        nnData.accuracy = ACCURACY_EXACT;
+      } else if (!strcmp(argv[2], "fast")) {
+        nnData.accuracy = ACCURACY_FAST;
+      } else if (!strcmp(argv[2], "faster")) {
+        nnData.accuracy = ACCURACY_FASTER;
+      } else {
+        fprintf(stderr, "Unknown accuracy %s\n", argv[2]);
+        exit(1);
+      }
+      consumeArguments(argc, argv, 2);
+    } else {
+      fprintf(stderr, "Unknown option %s\n", argv[1]);
+      exit(1);
+    }
+  }
+
+  if (!selectKernels(kernelsName)) {
+    fprintf(stderr, "This cpu can't run the %s kernels.\n", kernelsName);
+    exit(1);
+  }
+
+#ifdef SLOW
+  // one input at a time can't be split between threads
+  nnData.threads = 1;
+  nnData.deterministic = 0;
+  nnData.streamBlock = 0;
+#endif
+  // the threads parse the training set before they train on it
+  // the benchmarks that call initNN again with the same number of threads keep
+  // using the same ones, and a different number replaces them
+  if (pool.threads != nnData.threads) {
+    if (pool.threads)
+      stopPool(&pool);
+    initPool(&pool, nnData.threads);
+  }
+
+  initFastMath();
+  // stream 0 is for everything but clustering, which uses CLUSTER_STREAM
+  seedRng(&nnData.rng, nnData.seed, 0);
+
   // read data file
-  if (*argc > 2 && !strcmp(argv[1], "-f")) {
-    // we got a file from the command line
-    readTrainingSet(argv[2]);
-    // remove this part of the command line so it isn't processed later
-    memmove(argv + 1, argv + 3, (*argc - 3) * sizeof(char *));
-    (*argc) -= 2;
-  } else {
-    readTrainingSet("spiral.dat");
+#ifndef SLOW
+  if (nnData.streamBlock > 0)
+    openTrainingStream(file);
+  else
+#endif
+  if (!readDataset(&nnData.inputs, file, &pool)) {
+    fprintf(stderr, "Can't read %s.\n", file);
+    exit(1);
+  }
+  // nothing would ever be presented, and the mse would divide by 0
+  if (nnData.inputs.size == 0) {
+    fprintf(stderr, "%s has no inputs.\n", file);
+    exit(1);
+  }
+  // this is in order but will be shuffled on the first learn
+  nnData.order = (unsigned int *)malloc(nnData.inputs.size * sizeof(unsigned int));
+  for (i = 0; i < nnData.inputs.size; i++) {
+    nnData.order[i] = i;
   }
+  if (nnData.shuffleCopy)
+    allocateDataset(&nnData.shuffledInputs, nnData.inputs.size);
 
   nnData.momentum = 0.95;
   nnData.learnRate = 0.0001;
   nnData.epoch = 0;
-  nnData.isRBF = 0;
-
-  if (*argc > 1 && !strcmp(argv[1], "-r")) {
-    nnData.isRBF = 1;
-    memmove(argv + 1, argv + 2, (*argc - 2) * sizeof(char *));
-    (*argc) -= 1;
-  }
 
   // the number of hidden layers is specified on the command line
   // main 5 5 produces a network 2 5 5 1
@@ -367,7 +1101,6 @@ void initNN(int *argc, char **argv) {
   nnData.layerSizes[0] = 2;
   nnData.weightsSize = 0;
   nnData.valuesSize = 5; // this 5 is the final value, the inputs, and 2 biases
-  nnData.preActivatesSize = 1; // this 1 is the final value
   nnData.errorsSize = 1; // the final value
   // populate layerSizes and determine the sizes of arrays we need to allocate
   for (i = 1; i < *argc; i++) {
@@ -377,8 +1110,7 @@ void initNN(int *argc, char **argv) {
     // each node has one value, and each layer has a bias
     // the output layer has an unused bias value in it
     nnData.valuesSize += 1 + nnData.layerSizes[i];
-    // one preactivate and error space per node
-    nnData.preActivatesSize += nnData.layerSizes[i];
+    // one error space per node
     nnData.errorsSize += nnData.layerSizes[i];
   }
   // the output layer is not handled by the loop
@@ -387,8 +1119,7 @@ void initNN(int *argc, char **argv) {
   // these are part of the second layer, but extra RBF stuff
   if (nnData.isRBF) {
     // we'll let the input layer keep its bias, even though it's unused
-    // no preactivates or errors for the RBF layer
-    nnData.preActivatesSize -= nnData.layerSizes[1];
+    // no errors for the RBF layer
     nnData.errorsSize -= nnData.layerSizes[1];
   }
 
@@ -401,76 +1132,104 @@ void initNN(int *argc, char **argv) {
   // we don't want to use activation for a single perceptron
   if (nnData.layers - (nnData.isRBF ? 1 : 0) == 2)
     nnData.function = ACTIVATION_STEP;
-  // but for the C code we'll just use a virtual function call to save cycles
+  // the C code gets a copy of the training code made just for the function
+  // and the accuracy
   switch (nnData.function) {
     case ACTIVATION_HYPERBOLIC_TANGENT:
-      nnData.activate = &activate_htan;
-      nnData.derive = &derive_htan;
+      trainer = &htanTrainers[nnData.accuracy];
       break;
     case ACTIVATION_LOGISTIC:
-      nnData.activate = &activate_log;
-      nnData.derive = &derive_log;
+      trainer = &logTrainers[nnData.accuracy];
       break;
     case ACTIVATION_STEP:
-      nnData.activate = &activate_step;
-      nnData.derive = &derive_step;
+      trainer = &stepTrainers[nnData.accuracy];
+      break;
     case ACTIVATION_LINEAR:
-      nnData.activate = &activate_linear;
-      nnData.derive = &derive_linear;
+      trainer = &linearTrainers[nnData.accuracy];
+      break;
   }
+  // a batch never needs to be bigger than the training set, or a block of it
+  if (nnData.batchSize > nnData.inputs.size)
+    nnData.batchSize = nnData.inputs.size;
 
   // allocate our arrays
   nnData.weights = (GLfloat *)malloc(nnData.weightsSize * sizeof(GLfloat));
-  nnData.momentums = (double *)malloc(nnData.weightsSize * sizeof(double));
-  nnData.values = (double *)malloc(nnData.valuesSize * sizeof(double));
-  nnData.preActivates = (double *)malloc(nnData.preActivatesSize * sizeof(double));
-  nnData.errors = (double *)malloc(nnData.errorsSize * sizeof(double));
+  nnData.momentums = (NNFloat *)malloc(nnData.weightsSize * sizeof(NNFloat));
 
   // allocate convenience arrays
   nnData.layerWeights = (GLfloat **)malloc(nnData.layers * sizeof(GLfloat *));
-  nnData.layerMomentums = (double **)malloc(nnData.layers * sizeof(double *));
-  nnData.layerPreActivates = (double **)malloc(nnData.layers * sizeof(double *));
-  nnData.layerValues = (double **)malloc(nnData.layers * sizeof(double *));
-  nnData.layerErrors = (double **)malloc(nnData.layers * sizeof(double *));
+  nnData.layerMomentums = (NNFloat **)malloc(nnData.layers * sizeof(NNFloat *));
   // initialize convenience arrays
   nnData.layerWeights[0] = nnData.weights;
   nnData.layerMomentums[0] = nnData.momentums;
-  nnData.layerValues[0] = nnData.values;
-  // these two are bogus values because the input layer does not have them
-  // they need populated because the other layers are offsets from the first
-  nnData.layerPreActivates[0] = nnData.preActivates - nnData.layerSizes[0];
-  nnData.layerErrors[0] = nnData.errors - nnData.layerSizes[0];
-  if (nnData.isRBF) {
-    nnData.layerPreActivates[0] -= nnData.layerSizes[1];
-    nnData.layerErrors[0] -= nnData.layerSizes[1];
-  }
   for (i = 1; i < nnData.layers; i++) {
     nnData.layerWeights[i] = nnData.layerWeights[i - 1] + (nnData.layerSizes[i - 1] + 1) * nnData.layerSizes[i];
     nnData.layerMomentums[i] = nnData.layerMomentums[i - 1] + (nnData.layerSizes[i - 1] + 1) * nnData.layerSizes[i];
-    nnData.layerValues[i] = nnData.layerValues[i - 1] + nnData.layerSizes[i - 1] + 1;
-    nnData.layerErrors[i] = nnData.layerErrors[i - 1] + nnData.layerSizes[i - 1];
-    nnData.layerPreActivates[i] = nnData.layerPreActivates[i - 1] + nnData.layerSizes[i - 1];
   }
   // change the bogus values to nulls
-  nnData.layerPreActivates[0] = NULL;
-  nnData.layerErrors[0] = NULL;
   nnData.layerWeights[nnData.layers - 1] = NULL;
-  if (nnData.isRBF) {
-    nnData.layerPreActivates[1] = NULL;
-    nnData.layerErrors[1] = NULL;
+
+  // every thread gets its own place to work
+  nnData.scratch = (NNScratch *)malloc(nnData.threads * sizeof(NNScratch));
+  for (i = 0; i < nnData.threads; i++) {
+    initScratch(nnData.scratch + i);
+  }
+  if (nnData.deterministic) {
+    unsigned int shards = (nnData.batchSize + SHARD_SIZE - 1) / SHARD_SIZE;
+    nnData.shardGradients = (NNFloat *)malloc(shards * nnData.weightsSize * sizeof(NNFloat));
+    nnData.shardMSE = (double *)malloc(shards * sizeof(double));
   }
 
   // initialize weights
   for (i = 0; i < nnData.weightsSize; i++) {
-    nnData.weights[i] = 0.5 - random() / (double) 0x7fffffff;
+    nnData.weights[i] = 0.5 - randomUnit(&nnData.rng);
   }
   // initialize momentums
-  bzero(nnData.momentums, nnData.weightsSize * sizeof(double));
-  // initialize biases
-  for (i = 0; i < nnData.layers; i++) {
-    nnData.layerValues[i][0] = 1.0;
-  }
+  bzero(nnData.momentums, nnData.weightsSize * sizeof(NNFloat));
   if (nnData.isRBF) {
-    cluster();
+    cluster(file);
+    if (nnData.rbfCutoff > 0.0)
+      buildRBFGrid(&nnData.rbfGrid, nnData.weights, nnData.layerSizes[0] + 1, nnData.layerSizes[1], nnData.rbfCutoff);
+    // a block is only in memory while it trains
+    if (nnData.streamBlock == 0)
+      cacheRBF();
+  }
+}
+
+void freeNN() {
+  int i;
+  for (i = 0; i < nnData.threads; i++) {
+    freeScratch(nnData.scratch + i);
+  }
+  free(nnData.scratch);
+  if (nnData.deterministic) {
+    free(nnData.shardGradients);
+    free(nnData.shardMSE);
+  }
+  free(nnData.weights);
+  free(nnData.momentums);
+  free(nnData.layerWeights);
+  free(nnData.layerMomentums);
+  free(nnData.layerSizes);
+  free(nnData.order);
+  freeDataset(&nnData.inputs);
+  if (nnData.shuffleCopy)
+    freeDataset(&nnData.shuffledInputs);
+  if (nnData.streamBlock > 0) {
+    closeDatasetStream(&nnData.stream);
+    free(nnData.streamBlocks);
+    free(nnData.streamOrder);
+    freeDataset(&nnData.streamBuffers[0]);
+    freeDataset(&nnData.streamBuffers[1]);
   }
+  free(nnData.rbfCache);
+  free(nnData.rbfSparseStart);
+  free(nnData.rbfSparseCenters);
+  free(nnData.rbfSparseValues);
+  nnData.rbfCache = NULL;
+  nnData.rbfSparseStart = NULL;
+  nnData.rbfSparseCenters = NULL;
+  nnData.rbfSparseValues = NULL;
+  if (nnData.isRBF && nnData.rbfCutoff > 0.0)
+    freeRBFGrid(&nnData.rbfGrid);
 }
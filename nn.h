@@ -1,2 +1,18 @@
 double learn();
+// the fraction of the training set the network puts in the right class, from
+// the first block with -O
+double accuracy();
 void initNN(int *argc, char **argv);
+// drop some arguments after the program name once they have been handled, for
+// programs with options of their own in front of initNN's
+void consumeArguments(int *argc, char **argv, int count);
+// free everything initNN allocated, so it can be called again
+void freeNN();
+
+// with -DPROFILE, print where the time in learn went since the last report
+// every nnData.profileEpochs epochs, so call it after every epoch's line
+#ifdef PROFILE
+void reportProfile();
+#else
+#define reportProfile()
+#endif
@@ -0,0 +1,68 @@
+/*\
+ * Homework 2 - a neural network with a real-time preview
+ * Copyright (C) 2010 Matthew Donoughe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRENTY; without even the implied warrenty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. Tee the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Pubilc License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+\*/
+
+#ifdef __WIN32__
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#elif defined(__APPLE__)
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+#include "profile.h"
+
+const char *phaseNames[PHASE_COUNT] = {"forward", "backward", "update", "shuffle", "clear", "mse"};
+
+unsigned long long profileNow() {
+#ifdef __WIN32__
+  static LARGE_INTEGER frequency;
+  LARGE_INTEGER count;
+  if (frequency.QuadPart == 0)
+    QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&count);
+  return (unsigned long long)(count.QuadPart / (double)frequency.QuadPart * 1e9);
+#elif defined(__APPLE__)
+  // os x 10.5 has no clock_gettime
+  static mach_timebase_info_data_t timebase;
+  if (timebase.denom == 0)
+    mach_timebase_info(&timebase);
+  return mach_absolute_time() * timebase.numer / timebase.denom;
+#else
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec * 1000000000ULL + time.tv_nsec;
+#endif
+}
+
+#ifdef PROFILE
+double profileTickRate() {
+  static double rate = 0.0;
+  if (rate == 0.0) {
+    // spin for 20ms of the clock and see how many ticks go by
+    unsigned long long startTime = profileNow();
+    unsigned long long startTicks = profileTicks();
+    unsigned long long time;
+    do {
+      time = profileNow();
+    } while (time - startTime < 20000000);
+    rate = (profileTicks() - startTicks) * 1e9 / (time - startTime);
+  }
+  return rate;
+}
+#endif
@@ -0,0 +1,104 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+// where the time in learn goes, when built with -DPROFILE
+// each training thread adds up the ticks it spends in each phase, and in each
+// layer of the phases that go a layer at a time, in its own NNScratch, so
+// nothing is shared, and without PROFILE the macros are empty so the timing
+// costs nothing
+// reading the clock around every phase of every input would cost more than
+// small networks spend training, so only one input or batch in
+// PROFILE_INTERVAL is timed, and its ticks count PROFILE_INTERVAL times
+// the phases that happen once an epoch are timed every time
+
+typedef enum Phase {
+  // the inputs, the rbf layer, and the outputs of every layer
+  PHASE_FORWARD,
+  // the errors of every layer
+  PHASE_BACKWARD,
+  // the weight changes and applying them
+  PHASE_UPDATE,
+  // shuffling the inputs at the start of an epoch
+  PHASE_SHUFFLE,
+  // zeroing the errors before each input or batch
+  PHASE_CLEAR,
+  // the output's error and adding it to the mse
+  PHASE_MSE,
+  PHASE_COUNT
+} Phase;
+
+// the phases before this one are also split up by layer
+#define PHASE_LAYERED (PHASE_UPDATE + 1)
+
+#define PROFILE_INTERVAL 64
+
+extern const char *phaseNames[PHASE_COUNT];
+
+// nanoseconds since some point, from the fastest clock that doesn't go
+// backwards
+// the benchmarks use it for wall time with or without PROFILE
+unsigned long long profileNow();
+
+#ifdef PROFILE
+// ticks of the time stamp counter where there is one, which is much cheaper to
+// read than the clock, or nanoseconds otherwise
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define PROFILE_TSC
+#define profileTicks() __rdtsc()
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define PROFILE_TSC
+static __inline__ unsigned long long profileTicks() {
+  unsigned int low, high;
+  __asm__ __volatile__("rdtsc" : "=a"(low), "=d"(high));
+  return ((unsigned long long)high << 32) | low;
+}
+#else
+#define profileTicks() profileNow()
+#endif
+
+#ifdef PROFILE_TSC
+#define PROFILE_UNIT "cycles"
+#else
+#define PROFILE_UNIT "ns"
+#endif
+
+// ticks per second, measured against the clock the first time
+double profileTickRate();
+
+// start timing one input or batch, if it's one of the timed ones
+#define PROFILE_SAMPLE(scratch) do { \
+    (scratch)->profileWeight = PROFILE_INTERVAL; \
+    (scratch)->profileMark = ++(scratch)->profileCalls % PROFILE_INTERVAL == 0 ? profileTicks() : 0; \
+  } while (0)
+// start timing something that's always timed
+#define PROFILE_MARK(scratch) do { \
+    (scratch)->profileWeight = 1; \
+    (scratch)->profileMark = profileTicks(); \
+  } while (0)
+// add the time since the last mark to phase and start timing the next one
+#define PROFILE_ADD(scratch, phase) do { \
+    if ((scratch)->profileMark != 0) { \
+      unsigned long long profileTime = profileTicks(); \
+      (scratch)->phaseTime[phase] += (profileTime - (scratch)->profileMark) * (scratch)->profileWeight; \
+      (scratch)->profileMark = profileTime; \
+    } \
+  } while (0)
+// the same for one layer of a phase before PHASE_LAYERED
+#define PROFILE_ADD_LAYER(scratch, phase, layer) do { \
+    if ((scratch)->profileMark != 0) { \
+      unsigned long long profileTime = profileTicks(); \
+      unsigned long long profileSpent = (profileTime - (scratch)->profileMark) * (scratch)->profileWeight; \
+      (scratch)->phaseTime[phase] += profileSpent; \
+      (scratch)->layerTime[(phase) * nnData.layers + (layer)] += profileSpent; \
+      (scratch)->profileMark = profileTime; \
+    } \
+  } while (0)
+#else
+#define PROFILE_SAMPLE(scratch)
+#define PROFILE_MARK(scratch)
+#define PROFILE_ADD(scratch, phase)
+#define PROFILE_ADD_LAYER(scratch, phase, layer)
+#endif
+
+#endif
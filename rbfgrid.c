@@ -0,0 +1,130 @@
+/*\
+ * Homework 2 - a neural network with a real-time preview
+ * Copyright (C) 2010 Matthew Donoughe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRENTY; without even the implied warrenty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. Tee the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Pubilc License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+\*/
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "rbfgrid.h"
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+// whether the circle around a center reaches into a cell
+static int touchesCell(const RBFGrid *grid, double x, double y, double radius, int cellX, int cellY) {
+  double left = grid->minX + cellX * grid->cellWidth;
+  double bottom = grid->minY + cellY * grid->cellHeight;
+  // the closest point of the cell to the center
+  double closestX = x < left ? left : (x > left + grid->cellWidth ? left + grid->cellWidth : x);
+  double closestY = y < bottom ? bottom : (y > bottom + grid->cellHeight ? bottom + grid->cellHeight : y);
+  return (closestX - x) * (closestX - x) + (closestY - y) * (closestY - y) <= radius * radius;
+}
+
+// go through every cell a center's circle reaches
+// with an index of -1 count the center in counts, otherwise put the index in
+// the next free spot of each cell, which counts keeps track of
+static void addToCells(RBFGrid *grid, const float *center, int index, unsigned int *counts) {
+  double radius = grid->cutoff * sqrt(center[2]);
+  int x0 = (int)floor((center[0] - radius - grid->minX) / grid->cellWidth);
+  int x1 = (int)floor((center[0] + radius - grid->minX) / grid->cellWidth);
+  int y0 = (int)floor((center[1] - radius - grid->minY) / grid->cellHeight);
+  int y1 = (int)floor((center[1] + radius - grid->minY) / grid->cellHeight);
+  int x, y;
+  x0 = x0 < 0 ? 0 : x0;
+  y0 = y0 < 0 ? 0 : y0;
+  x1 = x1 >= grid->cellsX ? grid->cellsX - 1 : x1;
+  y1 = y1 >= grid->cellsY ? grid->cellsY - 1 : y1;
+  for (y = y0; y <= y1; y++) {
+    for (x = x0; x <= x1; x++) {
+      if (touchesCell(grid, center[0], center[1], radius, x, y)) {
+        int cell = y * grid->cellsX + x;
+        if (index < 0)
+          counts[cell]++;
+        else
+          grid->cellCenters[counts[cell]++] = index;
+      }
+    }
+  }
+}
+
+void buildRBFGrid(RBFGrid *grid, const float *centers, int stride, int count, double cutoff) {
+  double maxX, maxY, width, height, side;
+  double radii = 0.0;
+  unsigned int *next;
+  int cells, i;
+  grid->cutoff = cutoff;
+  // cover every center's circle
+  grid->minX = grid->minY = HUGE_VAL;
+  maxX = maxY = -HUGE_VAL;
+  for (i = 0; i < count; i++) {
+    const float *center = centers + i * stride;
+    double radius = cutoff * sqrt(center[2]);
+    grid->minX = MIN(grid->minX, center[0] - radius);
+    grid->minY = MIN(grid->minY, center[1] - radius);
+    maxX = MAX(maxX, center[0] + radius);
+    maxY = MAX(maxY, center[1] + radius);
+    radii += radius;
+  }
+  width = maxX > grid->minX ? maxX - grid->minX : 0.0;
+  height = maxY > grid->minY ? maxY - grid->minY : 0.0;
+  // cells about half as wide as the average circle, so a cell only holds the
+  // centers whose circles overlap there, and more centers(which k-means packs
+  // closer with smaller circles) make more cells instead of fuller ones
+  // never more than about 4 cells per center though, which would copy every
+  // center into lots of cells
+  side = MAX(count > 0 ? radii / count / 2.0 : 0.0, MAX(width, height) / ceil(2.0 * sqrt((double)count)));
+  if (side <= 0.0)
+    side = 1.0;
+  grid->cellsX = MAX(1, (int)ceil(width / side));
+  grid->cellsY = MAX(1, (int)ceil(height / side));
+  grid->cellWidth = width > 0.0 ? width / grid->cellsX : 1.0;
+  grid->cellHeight = height > 0.0 ? height / grid->cellsY : 1.0;
+  cells = grid->cellsX * grid->cellsY;
+
+  // count the centers in each cell, then lay them out one cell after another
+  grid->cellStart = (unsigned int *)calloc(cells + 1, sizeof(unsigned int));
+  for (i = 0; i < count; i++) {
+    addToCells(grid, centers + i * stride, -1, grid->cellStart + 1);
+  }
+  for (i = 0; i < cells; i++) {
+    grid->cellStart[i + 1] += grid->cellStart[i];
+  }
+  grid->cellCenters = (unsigned int *)malloc((grid->cellStart[cells] + 1) * sizeof(unsigned int));
+  next = (unsigned int *)malloc(cells * sizeof(unsigned int));
+  for (i = 0; i < cells; i++) {
+    next[i] = grid->cellStart[i];
+  }
+  for (i = 0; i < count; i++) {
+    addToCells(grid, centers + i * stride, i, next);
+  }
+  free(next);
+}
+
+void freeRBFGrid(RBFGrid *grid) {
+  free(grid->cellStart);
+  free(grid->cellCenters);
+  grid->cellStart = NULL;
+  grid->cellCenters = NULL;
+}
+
+int rbfGridCell(const RBFGrid *grid, double x, double y) {
+  int cellX = (int)floor((x - grid->minX) / grid->cellWidth);
+  int cellY = (int)floor((y - grid->minY) / grid->cellHeight);
+  if (cellX < 0 || cellY < 0 || cellX >= grid->cellsX || cellY >= grid->cellsY)
+    return -1;
+  return cellY * grid->cellsX + cellX;
+}
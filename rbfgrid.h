@@ -0,0 +1,34 @@
+#ifndef RBFGRID_H
+#define RBFGRID_H
+
+// a uniform grid over the rbf centers, so a point only has to look at the
+// centers close enough to matter instead of all of them
+// a center counts as close if the point is within cutoff * sqrt(var) of it,
+// where the Gaussian has dropped to exp(-cutoff^2 / 2)
+typedef struct RBFGrid {
+  // how far from a center in standard deviations still counts
+  double cutoff;
+  // the corner of the grid and the size of each cell
+  double minX;
+  double minY;
+  double cellWidth;
+  double cellHeight;
+  int cellsX;
+  int cellsY;
+  // the centers that might be close to a point in cell c are
+  // cellCenters[cellStart[c]] up to cellCenters[cellStart[c + 1]]
+  // cells are numbered across then up
+  unsigned int *cellStart;
+  unsigned int *cellCenters;
+} RBFGrid;
+
+// build the grid for count centers laid out like the rbf weights
+// (meanx, meany, var, then the next center stride floats later)
+void buildRBFGrid(RBFGrid *grid, const float *centers, int stride, int count, double cutoff);
+void freeRBFGrid(RBFGrid *grid);
+
+// the cell a point falls in, or -1 if it's outside the grid and so not close
+// to any center
+int rbfGridCell(const RBFGrid *grid, double x, double y);
+
+#endif
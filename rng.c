@@ -0,0 +1,97 @@
+/*\
+ * Homework 2 - a neural network with a real-time preview
+ * Copyright (C) 2010 Matthew Donoughe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRENTY; without even the implied warrenty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. Tee the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Pubilc License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+\*/
+
+#include "rng.h"
+
+#define ROTATE(x, k) (((x) << (k)) | ((x) >> (64 - (k))))
+
+// spreads the bits of a seed out so even seeds like 1 and 2 give unrelated
+// states
+static unsigned long long splitMix(unsigned long long *state) {
+  unsigned long long z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// skip ahead 2^128 numbers
+static void jump(Rng *rng) {
+  static const unsigned long long polynomial[] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+  unsigned long long s[4] = {0, 0, 0, 0};
+  int i, b;
+  for (i = 0; i < 4; i++) {
+    for (b = 0; b < 64; b++) {
+      if (polynomial[i] & (1ULL << b)) {
+        s[0] ^= rng->s[0];
+        s[1] ^= rng->s[1];
+        s[2] ^= rng->s[2];
+        s[3] ^= rng->s[3];
+      }
+      nextRandom(rng);
+    }
+  }
+  rng->s[0] = s[0];
+  rng->s[1] = s[1];
+  rng->s[2] = s[2];
+  rng->s[3] = s[3];
+}
+
+void seedRng(Rng *rng, unsigned long long seed, unsigned int stream) {
+  unsigned int i;
+  rng->s[0] = splitMix(&seed);
+  rng->s[1] = splitMix(&seed);
+  rng->s[2] = splitMix(&seed);
+  rng->s[3] = splitMix(&seed);
+  for (i = 0; i < stream; i++) {
+    jump(rng);
+  }
+}
+
+unsigned long long nextRandom(Rng *rng) {
+  unsigned long long result = ROTATE(rng->s[1] * 5, 7) * 9;
+  unsigned long long t = rng->s[1] << 17;
+  rng->s[2] ^= rng->s[0];
+  rng->s[3] ^= rng->s[1];
+  rng->s[1] ^= rng->s[2];
+  rng->s[0] ^= rng->s[3];
+  rng->s[2] ^= t;
+  rng->s[3] = ROTATE(rng->s[3], 45);
+  return result;
+}
+
+unsigned int randomBelow(Rng *rng, unsigned int bound) {
+  // the top 32 bits times bound puts the answer in the top half of the
+  // product, and the bottom half says whether it landed in one of the few
+  // spots that would make some answers more likely than others
+  unsigned long long product = (nextRandom(rng) >> 32) * bound;
+  unsigned int low = (unsigned int)product;
+  if (low < bound) {
+    // 2^32 % bound, only needed for the rare retry
+    unsigned int threshold = (0U - bound) % bound;
+    while (low < threshold) {
+      product = (nextRandom(rng) >> 32) * bound;
+      low = (unsigned int)product;
+    }
+  }
+  return (unsigned int)(product >> 32);
+}
+
+double randomUnit(Rng *rng) {
+  // 53 bits fills a double's mantissa
+  return (nextRandom(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
@@ -0,0 +1,27 @@
+#ifndef RNG_H
+#define RNG_H
+
+// xoshiro256** seeded through splitmix64
+// http://prng.di.unimi.it/
+// the same seed gives the same numbers on every platform, unlike random(),
+// and every thread gets its own state so nothing is shared
+typedef struct Rng {
+  unsigned long long s[4];
+} Rng;
+
+// start the generator for a seed
+// stream picks one of many sequences for the same seed that never overlap,
+// one for each thread
+void seedRng(Rng *rng, unsigned long long seed, unsigned int stream);
+
+// 64 random bits
+unsigned long long nextRandom(Rng *rng);
+
+// a number from 0 up to but not including bound, with every one equally likely
+// http://arxiv.org/abs/1805.10941
+unsigned int randomBelow(Rng *rng, unsigned int bound);
+
+// a number from 0 up to but not including 1
+double randomUnit(Rng *rng);
+
+#endif
@@ -68,6 +68,14 @@ static const char *gaussian = "\
         }\
 ";
 
+// the same, but 0 outside the cutoff, which is filled in as cutoff^2
+static const char *gaussianCutoff = "\
+        float rbf(vec2 x, vec2 mean, float var) {\n\
+          float distance = pow(x.x - mean.x, 2) + pow(x.y - mean.y, 2);\n\
+          return step(distance, %.9g * var) * exp(-distance / (2 * var));\n\
+        }\
+";
+
 static const char *fragmentShader = "\
         #version 120\n\
         #extension GL_EXT_bindable_uniform : require\n\
@@ -126,7 +134,36 @@ static int createEQ(char **ret) {
   int starti = 1;
   char *dest;
   char *str;
-  if (nnData.isRBF) {
+  if (nnData.isRBF && nnData.rbfCutoff > 0.0) {
+    // every rbf value starts at 0 and only the centers in the pixel's grid
+    // cell are looked at, with a branch for each cell
+    RBFGrid *grid = &nnData.rbfGrid;
+    int cell;
+    starti++;
+    for (j = 0; j < nnData.layerSizes[1]; j++) {
+      len += lastlen = asprintf(&dest, "          float v0001%04x = 0.0;\n", j);
+      addPart(dest, lastlen, &eoParts);
+    }
+    len += lastlen = asprintf(&dest, "          vec2 cell = floor((vec2(v00000000, v00000001) - vec2(%.9g, %.9g)) / vec2(%.9g, %.9g));\n          float cellIndex = cell.y * %d.0 + cell.x;\n          if (cell.x < 0.0 || cell.y < 0.0 || cell.x >= %d.0 || cell.y >= %d.0) {\n          }", grid->minX, grid->minY, grid->cellWidth, grid->cellHeight, grid->cellsX, grid->cellsX, grid->cellsY);
+    addPart(dest, lastlen, &eoParts);
+    for (cell = 0; cell < grid->cellsX * grid->cellsY; cell++) {
+      unsigned int c;
+      if (grid->cellStart[cell] == grid->cellStart[cell + 1])
+        continue;
+      len += lastlen = asprintf(&dest, " else if (cellIndex == %d.0) {\n", cell);
+      addPart(dest, lastlen, &eoParts);
+      for (c = grid->cellStart[cell]; c < grid->cellStart[cell + 1]; c++) {
+        j = grid->cellCenters[c];
+        len += lastlen = asprintf(&dest, "            v0001%04x = rbf(vec2(v00000000, v00000001), vec2(weights[%d], weights[%d]), weights[%d]);\n", j, 3 * j, 3 * j + 1, 3 * j + 2);
+        addPart(dest, lastlen, &eoParts);
+      }
+      len += lastlen = 11;
+      addPart(strdup("          }"), lastlen, &eoParts);
+    }
+    len += lastlen = 1;
+    addPart(strdup("\n"), lastlen, &eoParts);
+    weightIndex += 3 * nnData.layerSizes[1];
+  } else if (nnData.isRBF) {
     starti++;
     for (j = 0; j < nnData.layerSizes[1]; j++) {
       len += lastlen = asprintf(&dest, "          float v0001%04x = rbf(vec2(v00000000, v00000001), vec2(weights[%d], weights[%d]), weights[%d]);\n", j, weightIndex, weightIndex + 1, weightIndex + 2);
@@ -184,9 +221,12 @@ static const char *activation() {
 int createFShader(char **ret) {
   int retLen;
   char *eq;
+  char *rbf;
   createEQ(&eq);
-  retLen = asprintf(ret, fragmentShader, nnData.weightsSize, activation(), gaussian, eq);
+  asprintf(&rbf, nnData.rbfCutoff > 0.0 ? gaussianCutoff : gaussian, nnData.rbfCutoff * nnData.rbfCutoff);
+  retLen = asprintf(ret, fragmentShader, nnData.weightsSize, activation(), rbf, eq);
   free(eq);
+  free(rbf);
   printf("%s", *ret);
   return retLen;
 }
@@ -0,0 +1,89 @@
+/*\
+ * Homework 2 - a neural network with a real-time preview
+ * Copyright (C) 2010 Matthew Donoughe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRENTY; without even the implied warrenty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. Tee the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Pubilc License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+\*/
+
+#include <string.h>
+#include <math.h>
+
+#include "synth.h"
+
+#define PI 3.14159265358979
+
+static const char *shapeNames[] = {"spiral", "circles", "checkerboard", "xor"};
+
+int findSynthShape(const char *name, SynthShape *shape) {
+  int i;
+  for (i = 0; i < sizeof(shapeNames) / sizeof(shapeNames[0]); i++) {
+    if (!strcmp(name, shapeNames[i])) {
+      *shape = (SynthShape)i;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+void synthesize(Dataset *chunk, unsigned int count, SynthShape shape, double noise, Rng *rng) {
+  unsigned int i;
+  for (i = 0; i < count; i++) {
+    double a = randomUnit(rng);
+    double b = randomUnit(rng);
+    double x, y;
+    int target;
+    switch (shape) {
+      case SYNTH_SPIRAL: {
+        // a picks how far along its arm and b picks the arm
+        double angle = 3.0 * 2.0 * PI * a;
+        double radius = 0.25 + 6.75 * a;
+        target = b < 0.5;
+        if (!target)
+          angle += PI;
+        x = radius * sin(angle);
+        y = radius * cos(angle);
+        break;
+      }
+      case SYNTH_CIRCLES: {
+        // a picks the ring and b how far around it
+        int ring = (int)(3.0 * a);
+        x = (3 * ring + 1) * cos(2.0 * PI * b);
+        y = (3 * ring + 1) * sin(2.0 * PI * b);
+        target = ring % 2;
+        break;
+      }
+      case SYNTH_CHECKERBOARD:
+        x = 20.0 * a - 10.0;
+        y = 20.0 * b - 10.0;
+        target = ((int)(a * 4.0) + (int)(b * 4.0)) % 2;
+        break;
+      default:
+        x = 20.0 * a - 10.0;
+        y = 20.0 * b - 10.0;
+        target = (x < 0.0) != (y < 0.0);
+        break;
+    }
+    if (noise > 0.0) {
+      // Box-Muller
+      double length = noise * sqrt(-2.0 * log(1.0 - randomUnit(rng)));
+      double direction = 2.0 * PI * randomUnit(rng);
+      x += length * cos(direction);
+      y += length * sin(direction);
+    }
+    chunk->x[i] = x;
+    chunk->y[i] = y;
+    chunk->target[i] = 2 * target - 1;
+  }
+  chunk->size = count;
+}
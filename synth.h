@@ -0,0 +1,34 @@
+#ifndef SYNTH_H
+#define SYNTH_H
+
+#include "dataset.h"
+#include "rng.h"
+
+// generated training sets, for trying things at sizes the bundled ones don't
+// come close to
+// they cover the same -10 to 10 square as the .dat files
+typedef enum SynthShape {
+  // two arms winding around each other three times, like spiral.dat
+  SYNTH_SPIRAL,
+  // rings of radius 1, 4, and 7 alternating between the classes, like
+  // circle.dat
+  SYNTH_CIRCLES,
+  // 5 by 5 squares alternating between the classes
+  SYNTH_CHECKERBOARD,
+  // the classes in opposite quadrants, like xor.dat
+  SYNTH_XOR
+} SynthShape;
+
+// the shape called name(spiral, circles, checkerboard, or xor)
+// returns 0 if there isn't one
+int findSynthShape(const char *name, SynthShape *shape);
+
+// fill chunk, which has room for count inputs, with count inputs of shape and
+// set its size
+// noise is the standard deviation of the Gaussian noise added to each input
+// after its class is picked, so the classes overlap near the edges
+// every input takes the same amount of numbers from rng, so generating a set
+// a chunk at a time gives the same inputs as generating it all at once
+void synthesize(Dataset *chunk, unsigned int count, SynthShape shape, double noise, Rng *rng);
+
+#endif
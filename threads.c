@@ -0,0 +1,163 @@
+/*\
+ * Homework 2 - a neural network with a real-time preview
+ * Copyright (C) 2010 Matthew Donoughe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRENTY; without even the implied warrenty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. Tee the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Pubilc License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+\*/
+
+#include <stdlib.h>
+
+#include "threads.h"
+
+typedef struct Worker {
+  Pool *pool;
+  unsigned int thread;
+} Worker;
+
+void initBarrier(Barrier *barrier, unsigned int count) {
+#ifdef __WIN32__
+  InitializeCriticalSection(&barrier->lock);
+  InitializeConditionVariable(&barrier->changed);
+#else
+  pthread_mutex_init(&barrier->lock, NULL);
+  pthread_cond_init(&barrier->changed, NULL);
+#endif
+  barrier->count = count;
+  barrier->waiting = 0;
+  barrier->generation = 0;
+}
+
+void waitBarrier(Barrier *barrier) {
+  unsigned int generation;
+#ifdef __WIN32__
+  EnterCriticalSection(&barrier->lock);
+#else
+  pthread_mutex_lock(&barrier->lock);
+#endif
+  generation = barrier->generation;
+  if (++barrier->waiting == barrier->count) {
+    // last one in lets everyone go
+    barrier->waiting = 0;
+    barrier->generation++;
+#ifdef __WIN32__
+    WakeAllConditionVariable(&barrier->changed);
+#else
+    pthread_cond_broadcast(&barrier->changed);
+#endif
+  } else {
+    // wakeups can be spurious so check the generation actually changed
+    while (generation == barrier->generation) {
+#ifdef __WIN32__
+      SleepConditionVariableCS(&barrier->changed, &barrier->lock, INFINITE);
+#else
+      pthread_cond_wait(&barrier->changed, &barrier->lock);
+#endif
+    }
+  }
+#ifdef __WIN32__
+  LeaveCriticalSection(&barrier->lock);
+#else
+  pthread_mutex_unlock(&barrier->lock);
+#endif
+}
+
+void destroyBarrier(Barrier *barrier) {
+#ifdef __WIN32__
+  DeleteCriticalSection(&barrier->lock);
+#else
+  pthread_mutex_destroy(&barrier->lock);
+  pthread_cond_destroy(&barrier->changed);
+#endif
+}
+
+#ifndef __WIN32__
+static void *work(void *v) {
+#else
+static DWORD WINAPI work(LPVOID v) {
+#endif
+  Worker *worker = (Worker *)v;
+  Pool *pool = worker->pool;
+  while (1) {
+    waitBarrier(&pool->start);
+    // stopPool starts the workers with no function
+    if (!pool->function)
+      break;
+    pool->function(worker->thread, pool->arg);
+    waitBarrier(&pool->done);
+  }
+  free(worker);
+#ifndef __WIN32__
+  return NULL;
+#else
+  return 0;
+#endif
+}
+
+void initPool(Pool *pool, unsigned int threads) {
+  unsigned int i;
+  pool->threads = threads;
+  pool->function = NULL;
+  pool->arg = NULL;
+  initBarrier(&pool->start, threads);
+  initBarrier(&pool->done, threads);
+  pool->workers = NULL;
+  if (threads > 1)
+    pool->workers = malloc((threads - 1) * sizeof(*pool->workers));
+  for (i = 1; i < threads; i++) {
+    // the worker frees this when it returns
+    Worker *worker = (Worker *)malloc(sizeof(Worker));
+    worker->pool = pool;
+    worker->thread = i;
+#ifndef __WIN32__
+    pthread_create(&pool->workers[i - 1], NULL, &work, worker);
+#else
+    pool->workers[i - 1] = CreateThread(NULL, 0, &work, worker, 0, NULL);
+#endif
+  }
+}
+
+void runPool(Pool *pool, PoolFunction function, void *arg) {
+  if (pool->threads == 1) {
+    // nothing to wait for
+    function(0, arg);
+    return;
+  }
+  pool->function = function;
+  pool->arg = arg;
+  // the barriers order the writes above before the workers read them
+  waitBarrier(&pool->start);
+  function(0, arg);
+  waitBarrier(&pool->done);
+}
+
+void stopPool(Pool *pool) {
+  unsigned int i;
+  if (pool->threads > 1) {
+    pool->function = NULL;
+    waitBarrier(&pool->start);
+    for (i = 1; i < pool->threads; i++) {
+#ifndef __WIN32__
+      pthread_join(pool->workers[i - 1], NULL);
+#else
+      WaitForSingleObject(pool->workers[i - 1], INFINITE);
+      CloseHandle(pool->workers[i - 1]);
+#endif
+    }
+  }
+  free(pool->workers);
+  pool->workers = NULL;
+  destroyBarrier(&pool->start);
+  destroyBarrier(&pool->done);
+  pool->threads = 0;
+}
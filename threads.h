@@ -0,0 +1,60 @@
+#ifndef THREADS_H
+#define THREADS_H
+
+#ifdef __WIN32__
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif
+
+// waits until count threads have arrived
+// os x doesn't have pthread barriers so this is made out of a condition
+typedef struct Barrier {
+#ifdef __WIN32__
+  CRITICAL_SECTION lock;
+  CONDITION_VARIABLE changed;
+#else
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+#endif
+  unsigned int count;
+  unsigned int waiting;
+  // bumped every time everyone arrives so the waiters know to go
+  unsigned int generation;
+} Barrier;
+
+void initBarrier(Barrier *barrier, unsigned int count);
+void waitBarrier(Barrier *barrier);
+void destroyBarrier(Barrier *barrier);
+
+// thread is 0 for the thread that called runPool and 1 and up for the workers
+typedef void (*PoolFunction)(unsigned int thread, void *arg);
+
+// a set of threads that sleep until there's work for all of them
+typedef struct Pool {
+  // the number of threads including the one calling runPool
+  unsigned int threads;
+  Barrier start;
+  Barrier done;
+  PoolFunction function;
+  void *arg;
+  // the workers, so stopPool can wait for them to return
+#ifdef __WIN32__
+  HANDLE *workers;
+#else
+  pthread_t *workers;
+#endif
+} Pool;
+
+// start threads - 1 worker threads
+void initPool(Pool *pool, unsigned int threads);
+// call function on every thread of the pool and wait for all of them to finish
+void runPool(Pool *pool, PoolFunction function, void *arg);
+// make the workers return and wait for them, after which the pool can be
+// started again with initPool
+void stopPool(Pool *pool);
+
+#endif
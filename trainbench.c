@@ -0,0 +1,258 @@
+/*\
+ * Homework 2 - a neural network with a real-time preview
+ * Copyright (C) 2010 Matthew Donoughe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRENTY; without even the implied warrenty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. Tee the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Pubilc License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+\*/
+
+// measures how fast training goes, so kernel changes can be compared
+// trainbench [generated set size] [threads]
+// trains the same networks from the same seed on xor.dat, circle.dat,
+// spiral.dat, and a generated checkerboard for a fixed number of epochs each,
+// and prints a tab separated row per run with the time per input, split into
+// the phases in profile.h when built with -DPROFILE ("make bench" does that and
+// saves the rows to bench.tsv)
+// with more than one thread the phase times are added up over the threads
+// trainbench -a [seeds] [threads]
+// measures how long it takes to learn instead, which also catches changes to
+// the learning itself: trains each network from each seed on or.dat, xor.dat,
+// circle.dat, and spiral.dat until it classifies enough of the set right or gets
+// the mse low enough, and prints the median and 90th percentile of the time,
+// epochs, and inputs it took ("make bench-accuracy" saves them to
+// accuracy.tsv)
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "main.h"
+#include "nn.h"
+#include "rng.h"
+#include "synth.h"
+
+// where the generated set is written for initNN to read
+#define GENERATED_FILE "trainbench.bin"
+
+GLData glData;
+NNData nnData;
+
+typedef struct BenchSet {
+  const char *file;
+  // enough epochs that even xor takes long enough to time
+  unsigned int epochs;
+} BenchSet;
+
+typedef struct BenchNetwork {
+  const char *name;
+  // the rest of the command line initNN gets, ending with NULL
+  char *arguments[8];
+} BenchNetwork;
+
+static const BenchNetwork networks[] = {
+  {"mlp 10 10", {"10", "10", NULL}},
+  {"mlp 10 10 -b 32", {"-b", "32", "10", "10", NULL}},
+  {"mlp 64 64 -b 32", {"-b", "32", "64", "64", NULL}},
+  {"rbf 30 10", {"-r", "30", "10", NULL}},
+  {"rbf 150 10 -b 32", {"-r", "-b", "32", "150", "10", NULL}}
+};
+
+typedef struct AccuracyGoal {
+  const char *file;
+  // stop once this much of the set is classified right or the mse is this low
+  double accuracy;
+  double mse;
+  // and give up after this many epochs
+  unsigned int limit;
+} AccuracyGoal;
+
+static const AccuracyGoal goals[] = {
+  {"or.dat", 1.0, 0.01, 100000},
+  {"xor.dat", 1.0, 0.01, 100000},
+  {"circle.dat", 1.0, 0.01, 20000},
+  // an mlp this small gets stuck short of the whole spiral
+  {"spiral.dat", 0.9, 0.05, 10000}
+};
+
+static const BenchNetwork accuracyNetworks[] = {
+  {"mlp 20 20", {"20", "20", NULL}},
+  {"mlp 20 20 -b 8", {"-b", "8", "20", "20", NULL}},
+  {"rbf 30 10", {"-r", "30", "10", NULL}}
+};
+
+// start a network from a seed on a set, the same way for every run
+static void startNetwork(const char *file, const BenchNetwork *network, char *seed, char *threads) {
+  char *argv[16];
+  int argc = 0;
+  unsigned int i;
+  argv[argc++] = "trainbench";
+  argv[argc++] = "-s";
+  argv[argc++] = seed;
+  argv[argc++] = "-n";
+  argv[argc++] = "-t";
+  argv[argc++] = threads;
+  argv[argc++] = "-f";
+  argv[argc++] = (char *)file;
+  for (i = 0; network->arguments[i] != NULL; i++) {
+    argv[argc++] = network->arguments[i];
+  }
+  initNN(&argc, argv);
+}
+
+// train one network on one set and print its row
+static void benchmark(const BenchSet *set, const BenchNetwork *network, char *threads) {
+  unsigned long long samples, start, elapsed;
+  unsigned int i;
+  double mse = 0.0;
+  startNetwork(set->file, network, "1", threads);
+  start = profileNow();
+  for (i = 0; i < set->epochs; i++) {
+    mse = learn();
+  }
+  elapsed = profileNow() - start;
+  samples = (unsigned long long)nnData.inputs.size * set->epochs;
+  printf("%s\t%u\t%s\t%u\t%llu\t%.3f\t%.0f\t%.1f", set->file, nnData.inputs.size, network->name, set->epochs, samples, elapsed / 1e9, samples / (elapsed / 1e9), (double)elapsed / samples);
+#ifdef PROFILE
+  {
+    int p;
+    for (p = 0; p < PHASE_COUNT; p++) {
+      unsigned long long total = 0;
+      unsigned int t;
+      for (t = 0; t < nnData.threads; t++) {
+        total += nnData.scratch[t].phaseTime[p];
+      }
+      printf("\t%.1f", total * 1e9 / profileTickRate() / samples);
+    }
+  }
+#else
+  {
+    int p;
+    for (p = 0; p < PHASE_COUNT; p++) {
+      printf("\t-");
+    }
+  }
+#endif
+  printf("\t%g\n", mse);
+  fflush(stdout);
+  freeNN();
+}
+
+static int compareDoubles(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return x < y ? -1 : x > y;
+}
+
+// the value a fraction of the way through runs sorted values, with the nearest
+// rank, or - when that run never reached the goal
+static void printPercentile(const double *sorted, int runs, double fraction, const char *format) {
+  int rank = (int)ceil(fraction * runs) - 1;
+  putchar('\t');
+  if (sorted[rank] == HUGE_VAL)
+    putchar('-');
+  else
+    printf(format, sorted[rank]);
+}
+
+// train one network on one set from every seed until it reaches the goal and
+// print the spread of how long it took
+// only learn is timed, checking the accuracy after each epoch isn't
+static void benchmarkAccuracy(const AccuracyGoal *goal, const BenchNetwork *network, int seeds, char *threads) {
+  double *milliseconds = (double *)malloc(seeds * sizeof(double));
+  double *epochs = (double *)malloc(seeds * sizeof(double));
+  double *samples = (double *)malloc(seeds * sizeof(double));
+  int reached = 0;
+  int s;
+  for (s = 0; s < seeds; s++) {
+    char seed[16];
+    unsigned long long elapsed = 0;
+    double mse;
+    sprintf(seed, "%d", s + 1);
+    startNetwork(goal->file, network, seed, threads);
+    do {
+      unsigned long long start = profileNow();
+      mse = learn();
+      elapsed += profileNow() - start;
+    } while (mse > goal->mse && accuracy() < goal->accuracy && nnData.epoch < goal->limit);
+    if (mse <= goal->mse || accuracy() >= goal->accuracy) {
+      reached++;
+      milliseconds[s] = elapsed / 1e6;
+      epochs[s] = nnData.epoch;
+      samples[s] = (double)nnData.epoch * nnData.inputs.size;
+    } else {
+      milliseconds[s] = epochs[s] = samples[s] = HUGE_VAL;
+    }
+    freeNN();
+  }
+  qsort(milliseconds, seeds, sizeof(double), &compareDoubles);
+  qsort(epochs, seeds, sizeof(double), &compareDoubles);
+  qsort(samples, seeds, sizeof(double), &compareDoubles);
+  printf("%s\t%s\t%g\t%g\t%d\t%d", goal->file, network->name, goal->accuracy, goal->mse, seeds, reached);
+  printPercentile(milliseconds, seeds, 0.5, "%.3f");
+  printPercentile(milliseconds, seeds, 0.9, "%.3f");
+  printPercentile(epochs, seeds, 0.5, "%.0f");
+  printPercentile(epochs, seeds, 0.9, "%.0f");
+  printPercentile(samples, seeds, 0.5, "%.0f");
+  printPercentile(samples, seeds, 0.9, "%.0f");
+  putchar('\n');
+  fflush(stdout);
+  free(milliseconds);
+  free(epochs);
+  free(samples);
+}
+
+int main(int argc, char **argv) {
+  unsigned int size = argc > 1 ? atoi(argv[1]) : 1000000;
+  char *threads = argc > 2 ? argv[2] : "1";
+  BenchSet sets[] = {
+    {"xor.dat", 100000},
+    {"circle.dat", 5000},
+    {"spiral.dat", 2000},
+    {GENERATED_FILE, 2}
+  };
+  Dataset generated;
+  Rng rng;
+  int s, n;
+  if (argc > 1 && !strcmp(argv[1], "-a")) {
+    int seeds = argc > 2 ? atoi(argv[2]) : 11;
+    threads = argc > 3 ? argv[3] : "1";
+    printf("set\tnetwork\taccuracy goal\tmse goal\tseeds\treached\tmedian ms\tp90 ms\tmedian epochs\tp90 epochs\tmedian samples\tp90 samples\n");
+    for (s = 0; s < sizeof(goals) / sizeof(goals[0]); s++) {
+      for (n = 0; n < sizeof(accuracyNetworks) / sizeof(accuracyNetworks[0]); n++) {
+        benchmarkAccuracy(goals + s, accuracyNetworks + n, seeds < 1 ? 1 : seeds, threads);
+      }
+    }
+    return 0;
+  }
+  seedRng(&rng, 1, 0);
+  allocateDataset(&generated, size);
+  synthesize(&generated, size, SYNTH_CHECKERBOARD, 0.0, &rng);
+  if (!writeBinaryDataset(&generated, GENERATED_FILE, NULL)) {
+    fprintf(stderr, "Can't write %s.\n", GENERATED_FILE);
+    return 1;
+  }
+  freeDataset(&generated);
+  printf("set\tinputs\tnetwork\tepochs\tsamples\tseconds\tsamples/s\tns/sample");
+  for (n = 0; n < PHASE_COUNT; n++) {
+    printf("\t%s ns", phaseNames[n]);
+  }
+  printf("\tmse\n");
+  for (s = 0; s < sizeof(sets) / sizeof(sets[0]); s++) {
+    for (n = 0; n < sizeof(networks) / sizeof(networks[0]); n++) {
+      benchmark(sets + s, networks + n, threads);
+    }
+  }
+  remove(GENERATED_FILE);
+  return 0;
+}